@@ -6,6 +6,7 @@
 #include <QDockWidget>
 #include <QDragEnterEvent>
 #include <QDropEvent>
+#include <QInputDialog>
 #include <QMenuBar>
 #include <QMimeData>
 #include <QSlider>
@@ -72,10 +73,26 @@ void PhotoWindow::setupDialogs() {
     exportImageDialog = new QFileDialog(this, "Export image");
     exportImageDialog->setAcceptMode(QFileDialog::AcceptMode::AcceptSave);
     exportImageDialog->setFileMode(QFileDialog::FileMode::AnyFile);
-    exportImageDialog->setNameFilter("Images (*.jpg *.jpeg *.png)");
+    exportImageDialog->setNameFilter("Images (*.jpg *.jpeg *.png *.tif *.tiff *.exr)");
     exportImageDialog->setDirectory(QStandardPaths::writableLocation(QStandardPaths::PicturesLocation));
     connect(exportImageDialog, &QFileDialog::fileSelected, compositionManager, &CompositionManager::exportImage);
 
+    exportLutDialog = new QFileDialog(this, "Export LUT");
+    exportLutDialog->setAcceptMode(QFileDialog::AcceptMode::AcceptSave);
+    exportLutDialog->setFileMode(QFileDialog::FileMode::AnyFile);
+    exportLutDialog->setNameFilters({ "Cube LUTs (*.cube)", "Hald images (*.png *.tif *.tiff)" });
+    exportLutDialog->setDirectory(QStandardPaths::writableLocation(QStandardPaths::PicturesLocation));
+    connect(exportLutDialog, &QFileDialog::fileSelected, this, [this](const QString &qPath) {
+        QStringList sizes;
+        for (auto size : image::LUT_EXPORT_SIZES) { sizes << QString::number(size); }
+        bool ok = false;
+        auto size = QInputDialog::getItem(this, tr("Export LUT"), tr("LUT size"), sizes, 1, false, &ok).toInt();
+        if (!ok) { return; }
+        // The composition manager lives on the processor thread.
+        QMetaObject::invokeMethod(compositionManager,
+                                  [this, qPath, size] { compositionManager->exportLut(qPath, size); });
+    });
+
     openCompositionDialog = new QFileDialog(this, "Open composition");
     openCompositionDialog->setAcceptMode(QFileDialog::AcceptMode::AcceptOpen);
     openCompositionDialog->setFileMode(QFileDialog::FileMode::ExistingFile);
@@ -106,6 +123,9 @@ void PhotoWindow::setupActions() {
     exportImageAction = new QAction("&Export Image...", this);
     connect(exportImageAction, &QAction::triggered, this, [this] { exportImageDialog->show(); });
 
+    exportLutAction = new QAction("Export &LUT...", this);
+    connect(exportLutAction, &QAction::triggered, this, [this] { exportLutDialog->show(); });
+
     openCompositionAction = new QAction("&Open Composition...", this);
     openCompositionAction->setIcon(style()->standardIcon(QStyle::StandardPixmap::SP_DialogOpenButton));
     connect(openCompositionAction, &QAction::triggered, this, [this] { openCompositionDialog->show(); });
@@ -133,7 +153,15 @@ void PhotoWindow::setupActions() {
 
     toggleShowMaskOverlayAction = new QAction("&Show Mask Overlay", this);
     toggleShowMaskOverlayAction->setCheckable(true);
-    connect(toggleShowMaskOverlayAction, &QAction::toggled, activeMaskManager.get(), &MaskManager::setOverlayEnabled);
+    connect(toggleShowMaskOverlayAction, &QAction::toggled, this, [this](bool isEnabled) {
+        compositionManager->setMaskOverlayEnabled(isEnabled);
+        // Procedural masks aren't kept up to date while hidden, so fetch a fresh buffer before showing one.
+        auto maskGen = activeMaskManager->maskGen();
+        if (isEnabled && maskGen && compositionManager->processor()) {
+            activeMaskManager->handleMaskGenerated(maskGen, &compositionManager->processor()->state.mask(maskGen));
+        }
+        activeMaskManager->setOverlayEnabled(isEnabled);
+    });
 }
 
 void PhotoWindow::setupMenus() {
@@ -143,6 +171,7 @@ void PhotoWindow::setupMenus() {
     fileMenu->addSeparator();
     fileMenu->addAction(openImageAction);
     fileMenu->addAction(exportImageAction);
+    fileMenu->addAction(exportLutAction);
     fileMenu->addSeparator();
     fileMenu->addAction(openCompositionAction);
     fileMenu->addSeparator();
@@ -177,6 +206,25 @@ void PhotoWindow::setupDockWidgets() {
         addDockWidget(Qt::RightDockWidgetArea, dock);
         viewMenu->addAction(dock->toggleViewAction());
     }
+
+    {
+        auto dock = new QDockWidget(tr("Waveform"), this);
+        dock->setAllowedAreas(Qt::LeftDockWidgetArea | Qt::RightDockWidgetArea);
+        waveform = new Waveform();
+        waveform->setMaximumHeight(150);
+        dock->setWidget(waveform);
+        addDockWidget(Qt::RightDockWidgetArea, dock);
+        viewMenu->addAction(dock->toggleViewAction());
+    }
+
+    {
+        auto dock = new QDockWidget(tr("Vectorscope"), this);
+        dock->setAllowedAreas(Qt::LeftDockWidgetArea | Qt::RightDockWidgetArea);
+        vectorscope = new Vectorscope();
+        dock->setWidget(vectorscope);
+        addDockWidget(Qt::RightDockWidgetArea, dock);
+        viewMenu->addAction(dock->toggleViewAction());
+    }
     
     {
         auto dock = new QDockWidget(tr("Composition"), this);
@@ -196,7 +244,7 @@ void PhotoWindow::setupDockWidgets() {
             activeMaskManager->setMask(maskGen);
             // This is a little bit hacky. Basically we need to get the generated mask buffer for the new active mask
             // generator (if any) and give it to the mask manager to display in the overlay.
-            if (maskGen) {
+            if (maskGen && toggleShowMaskOverlayAction->isChecked()) {
                 activeMaskManager->handleMaskGenerated(maskGen, &compositionManager->processor()->state.mask(maskGen));
             }
         });
@@ -220,6 +268,12 @@ void PhotoWindow::setupProcessor() {
         saveCompositionAction->setEnabled(true);
         saveCompositionAsAction->setEnabled(true);
     });
+    connect(compositionManager, &CompositionManager::imageExported, this, [this](const QString &qPath, bool isSuccess) {
+        statusBar()->showMessage(isSuccess ? tr("Exported %1").arg(qPath) : tr("Failed to export %1").arg(qPath));
+    });
+    connect(compositionManager, &CompositionManager::lutExported, this, [this](const QString &qPath, bool isSuccess) {
+        statusBar()->showMessage(isSuccess ? tr("Exported %1").arg(qPath) : tr("Failed to export %1").arg(qPath));
+    });
     connect(compositionManager, &CompositionManager::compositionPathChanged, this, [this](const QString &qPath) {
         image::Path path = qPath.toStdString();
         setWindowTitle(QString::fromStdString(path.filename()));
@@ -255,8 +309,12 @@ void PhotoWindow::saveComposition() {
 }
 
 void PhotoWindow::updateImageView() {
-    auto &img = compositionManager->output();
-    QSize size { static_cast<int>(img.width()), static_cast<int>(img.height()) };
-    canvasScene->setImage(size, img.data());
-    histogram->generate(img);
+    auto output = compositionManager->output();
+    if (!output) { return; }
+    const auto &displaySize = compositionManager->displaySize();
+    canvasScene->setImage(*output,
+                          QSize { static_cast<int>(displaySize.x), static_cast<int>(displaySize.y) });
+    histogram->setHistogram(compositionManager->processor()->histogram);
+    waveform->setWaveform(compositionManager->waveform());
+    vectorscope->setVectorscope(compositionManager->vectorscope());
 }
@@ -11,6 +11,8 @@
 #include <app/masks/MaskManager.hpp>
 #include <app/widgets/Histogram.hpp>
 #include <app/widgets/ProcessingIndicator.hpp>
+#include <app/widgets/Vectorscope.hpp>
+#include <app/widgets/Waveform.hpp>
 
 class PhotoWindow : public QMainWindow {
     Q_OBJECT
@@ -46,6 +48,8 @@ private:
     ProcessingIndicator *processingIndicator;
     CompositionOutline *compositionOutline;
     Histogram *histogram;
+    Waveform *waveform;
+    Vectorscope *vectorscope;
 
     QString compositionPath;
     bool isCompositionFromFile { false };
@@ -55,6 +59,7 @@ private:
     QAction *newWindowAction;
     QAction *openImageAction;
     QAction *exportImageAction;
+    QAction *exportLutAction;
     QAction *openCompositionAction;
     QAction *saveCompositionAction;
     QAction *saveCompositionAsAction;
@@ -63,6 +68,7 @@ private:
 
     QFileDialog *openImageDialog;
     QFileDialog *exportImageDialog;
+    QFileDialog *exportLutDialog;
     QFileDialog *openCompositionDialog;
     QFileDialog *saveCompositionDialog;
 
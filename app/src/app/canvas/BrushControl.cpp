@@ -0,0 +1,41 @@
+#include <app/canvas/BrushControl.hpp>
+
+#include <QEvent>
+#include <QGraphicsSceneMouseEvent>
+
+BrushControl::BrushControl(CanvasScene *scene, QObject *parent) noexcept : CanvasControl(scene, parent) {
+    scene->installEventFilter(this);
+}
+
+BrushControl::~BrushControl() { scene()->removeEventFilter(this); }
+
+bool BrushControl::eventFilter(QObject *watched, QEvent *event) {
+    if (watched != scene()) { return false; }
+    switch (event->type()) {
+    case QEvent::GraphicsSceneMousePress: {
+        auto mouseEvent = static_cast<QGraphicsSceneMouseEvent *>(event);
+        if (mouseEvent->button() != Qt::LeftButton) { return false; }
+        isPainting_ = true;
+        emit strokeStarted(projectFromScene(mouseEvent->scenePos()), mouseEvent->modifiers().testFlag(Qt::AltModifier));
+        return true;
+    }
+    case QEvent::GraphicsSceneMouseMove: {
+        if (!isPainting_) { return false; }
+        auto mouseEvent = static_cast<QGraphicsSceneMouseEvent *>(event);
+        emit strokeExtended(projectFromScene(mouseEvent->scenePos()));
+        return true;
+    }
+    case QEvent::GraphicsSceneMouseRelease: {
+        if (!isPainting_) { return false; }
+        isPainting_ = false;
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+QPointF BrushControl::projectFromScene(const QPointF &point) const noexcept {
+    auto size = scene()->sceneRect().size();
+    return QPointF { point.x() / size.width(), point.y() / size.height() };
+}
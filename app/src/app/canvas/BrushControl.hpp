@@ -0,0 +1,31 @@
+#pragma once
+
+#include <QPointF>
+
+#include <app/canvas/CanvasControl.hpp>
+#include <app/canvas/CanvasScene.hpp>
+
+/**
+ * @brief Captures brush strokes painted on the canvas.
+ *
+ * Positions are normalised to the scene rect. Holding Alt when starting a stroke makes it erase.
+ */
+class BrushControl : public CanvasControl {
+    Q_OBJECT
+public:
+    explicit BrushControl(CanvasScene *scene, QObject *parent = nullptr) noexcept;
+
+    virtual ~BrushControl();
+
+signals:
+    void strokeStarted(const QPointF &pos, bool erase);
+    void strokeExtended(const QPointF &pos);
+
+protected:
+    virtual bool eventFilter(QObject *watched, QEvent *event) override;
+
+    QPointF projectFromScene(const QPointF &point) const noexcept;
+
+private:
+    bool isPainting_ { false };
+};
@@ -2,15 +2,20 @@
 
 CanvasScene::CanvasScene(QObject *parent) noexcept : QGraphicsScene(parent) {}
 
-void CanvasScene::setImage(QSize size, const image::U8 *data) noexcept {
+void CanvasScene::setImage(const image::ImageBuf<image::U8> &image, QSize displaySize) noexcept {
     clearImage();
-    std::size_t w = size.width();
-    std::size_t h = size.height();
-    // QImage ctor without bytesPerLine requires the image buffer, and each row
-    // of same are 32-bit aligned. We can't assume that so we specify bytes per
-    // line explicitly (width * numChannels * sizeof(T)).
-    QImage img(data, w, h, w * 3, QImage::Format::Format_RGB888);
+    std::size_t w = image.width();
+    std::size_t h = image.height();
+    QSize size { static_cast<int>(w), static_cast<int>(h) };
+    // Rows may be padded, so pass the image's own row pitch rather than let QImage assume one.
+    QImage img(image.data(), w, h, image.rowPitchBytes(), QImage::Format::Format_RGB888);
     imageItem_ = addPixmap(QPixmap::fromImage(std::move(img)));
+    if (displaySize.isValid() && displaySize != size) {
+        imageItem_->setTransformationMode(Qt::SmoothTransformation);
+        imageItem_->setTransform(QTransform::fromScale(static_cast<qreal>(displaySize.width()) / w,
+                                                       static_cast<qreal>(displaySize.height()) / h));
+        size = displaySize;
+    }
     setSceneRect(QRectF { QPointF { 0, 0 }, QSizeF { size } });
 }
 
@@ -5,6 +5,7 @@
 #include <QSize>
 
 #include <image/CoreTypes.hpp>
+#include <image/ImageBuf.hpp>
 
 class CanvasScene : public QGraphicsScene {
     Q_OBJECT
@@ -13,7 +14,11 @@ public:
 
     virtual ~CanvasScene() {}
 
-    void setImage(QSize size, const image::U8 *data) noexcept;
+    /**
+     * @brief Show an image. If displaySize is given, the image is scaled to cover it, e.g. for a preview standing in
+     * for a larger image.
+     */
+    void setImage(const image::ImageBuf<image::U8> &image, QSize displaySize = QSize()) noexcept;
     void clearImage() noexcept;
     const QGraphicsPixmapItem *imageItem() const noexcept { return imageItem_; }
 
@@ -8,13 +8,13 @@ CanvasView::CanvasView(QWidget *parent) noexcept : QGraphicsView(parent) {
 
 void CanvasView::resizeEvent(QResizeEvent *) {
     if (!scene_ || !scene_->imageItem()) { return; }
-    if (scaleToFit_) { fitInView(scene_->imageItem()->boundingRect(), Qt::AspectRatioMode::KeepAspectRatio); }
+    if (scaleToFit_) { fitInView(scene_->imageItem()->sceneBoundingRect(), Qt::AspectRatioMode::KeepAspectRatio); }
 }
 
 void CanvasView::mouseDoubleClickEvent(QMouseEvent *event) {
     scaleToFit_ = !scaleToFit_;
     if (scaleToFit_) {
-        fitInView(scene_->imageItem()->boundingRect(), Qt::AspectRatioMode::KeepAspectRatio);
+        fitInView(scene_->imageItem()->sceneBoundingRect(), Qt::AspectRatioMode::KeepAspectRatio);
         setDragMode(QGraphicsView::DragMode::NoDrag);
     } else {
         auto point = mapToScene(event->pos());
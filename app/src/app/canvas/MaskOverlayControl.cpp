@@ -18,17 +18,19 @@ void MaskOverlayControl::clearMask() noexcept {
     }
 }
 
-void MaskOverlayControl::setMask(const Mask &data) noexcept {
+void MaskOverlayControl::setMask(const Mask &data, memory::Size divisor) noexcept {
     memory::Size w = data.width();
     memory::Size h = data.height();
     if (overlayImageBuf_.size != ImageSize { w, h }) { overlayImageBuf_ = maskProcessor_->makeOverlayImageBuf(data); }
     maskProcessor_->generateOverlayImage(data, overlayImageBuf_);
 
-    QImage img(overlayImageBuf_.data(), w, h, w * 4, QImage::Format::Format_RGBA8888);
+    QImage img(overlayImageBuf_.data(), w, h, overlayImageBuf_.rowPitchBytes(), QImage::Format::Format_RGBA8888);
     if (!maskOverlayItem_) {
         maskOverlayItem_ = scene()->addPixmap(QPixmap::fromImage(std::move(img)));
         maskOverlayItem_->setZValue(5);
+        maskOverlayItem_->setTransformationMode(Qt::SmoothTransformation);
     } else {
         maskOverlayItem_->setPixmap(QPixmap::fromImage(std::move(img)));
     }
+    maskOverlayItem_->setScale(static_cast<qreal>(divisor));
 }
@@ -18,7 +18,10 @@ public:
     virtual ~MaskOverlayControl();
 
     void clearMask() noexcept;
-    void setMask(const image::Mask &data) noexcept;
+    /**
+     * @brief Show a mask. Reduced resolution masks are scaled up by divisor to cover the image.
+     */
+    void setMask(const image::Mask &data, image::memory::Size divisor = 1) noexcept;
 
 private:
     QGraphicsPixmapItem *maskOverlayItem_ { nullptr };
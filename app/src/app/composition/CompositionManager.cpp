@@ -13,6 +13,9 @@ using namespace image;
 
 namespace {
 
+    /// Pixels binned into each scope. Enough for display, and keeps the cost the same on large images.
+    constexpr memory::Size scopeSamples = 1 << 18;
+
     template <class T>
     void allocOpenCL(ImageBuf<T> &img) noexcept {
         img.pixelArray.buffer()->setDevice(opencl::Manager::the()->bufferDevice);
@@ -38,7 +41,14 @@ CompositionManager::CompositionManager(QObject *parent) noexcept
     connect(compositionModel_, &CompositionModel::maskChanged, this, &CompositionManager::notifyMaskChanged);
 }
 
+CompositionManager::~CompositionManager() noexcept {
+    cancelDecodes();
+    for (auto &job : decodeJobs_) { job->thread.join(); }
+}
+
 void CompositionManager::openComposition(const QString &qPath) noexcept {
+    // A decode of the previous image is no use any more.
+    cancelDecodes();
     emit imageStartedLoading(qPath);
     std::cerr << "[CompositionManager] Opening composition: " << qPath.toStdString() << "\n";
     Path path = qPath.toStdString();
@@ -49,6 +59,7 @@ void CompositionManager::openComposition(const QString &qPath) noexcept {
         return;
     }
     composition_ = std::make_shared<Composition>(std::move(compResult.value()));
+    isShowingPreview_ = false;
     allocOpenCL(*composition_->inputImage.data);
     writeToOpenCL(*composition_->inputImage.data);
     ensureOutput();
@@ -60,6 +71,8 @@ void CompositionManager::openComposition(const QString &qPath) noexcept {
     compositionModel_->setComposition(composition_);
     emit compositionChanged();
     emit compositionPathChanged(qPath);
+
+    startFullResolutionDecode();
 }
 
 void CompositionManager::saveComposition(const QString &qPath) noexcept {
@@ -70,15 +83,69 @@ void CompositionManager::saveComposition(const QString &qPath) noexcept {
 }
 
 void CompositionManager::openImage(const QString &qPath) noexcept {
+    // A decode of the previous image is no use any more.
+    cancelDecodes();
     emit imageStartedLoading(qPath);
     std::cerr << "[CompositionManager] Opening image: " << qPath.toStdString() << "\n";
     Path path = qPath.toStdString();
-    auto compResult = Composition::newFromPath(path);
-    composition_ = std::make_shared<Composition>(std::move(compResult.value()));
+    showEmbeddedPreview(path);
+
+    // Decode on a thread of its own, so that the preview can be edited meanwhile. The image is uploaded band by band
+    // while it's decoded, and handed back to this thread once it's done.
+    auto job = addDecodeJob();
+    job->thread = std::thread([this, job, path, qPath] {
+        auto compResult = Composition::newFromPath(
+            path, opencl::Manager::the()->bufferDevice, ImageReadOptions { .isCancelled = &job->isCancelled });
+        job->isFinished = true;
+        if (job->isCancelled) { return; }
+        if (compResult.hasError()) {
+            std::cerr << "[CompositionManager] Error opening image: " << path << "\n";
+            return;
+        }
+        auto comp = std::make_shared<Composition>(std::move(*compResult));
+        QMetaObject::invokeMethod(
+            this,
+            [this, job, qPath, comp] {
+                if (!job->isCancelled) { finishOpeningImage(qPath, comp); }
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+void CompositionManager::finishOpeningImage(const QString &qPath, std::shared_ptr<Composition> comp) noexcept {
+    // Keep any edits made to the preview.
+    if (isShowingPreview_) { comp->layers = composition_->layers; }
+    composition_ = comp;
+    isShowingPreview_ = false;
+    ensureOutput();
+    emit imageLoaded(qPath);
+
+    resetProcessor();
+    process();
+
+    compositionModel_->setComposition(composition_);
+    emit compositionChanged();
+
+    startFullResolutionDecode();
+}
+
+void CompositionManager::showEmbeddedPreview(const Path &path) noexcept {
+    // RAW files take seconds to decode, so process and show their embedded preview in the meantime.
+    auto preview = readEmbeddedPreviewFromFile<F32>(path);
+    if (preview.hasError()) { return; }
+    std::cerr << "[CompositionManager] Showing embedded preview\n";
+    auto comp = std::make_shared<Composition>();
+    comp->inputImage.filePath = path;
+    comp->inputImage.data = std::move(preview->image);
+    // So that an export started meanwhile decodes the image rather than exporting the preview.
+    comp->inputImage.isReduced = true;
+    comp->layers.push_back(std::make_shared<Layer>());
+    composition_ = comp;
+    isShowingPreview_ = true;
     allocOpenCL(*composition_->inputImage.data);
     writeToOpenCL(*composition_->inputImage.data);
     ensureOutput();
-    emit imageLoaded(qPath);
+    displaySize_ = preview->imageSize;
 
     resetProcessor();
     process();
@@ -87,15 +154,95 @@ void CompositionManager::openImage(const QString &qPath) noexcept {
     emit compositionChanged();
 }
 
+std::shared_ptr<CompositionManager::DecodeJob> CompositionManager::addDecodeJob() noexcept {
+    std::erase_if(decodeJobs_, [](const auto &job) {
+        if (!job->isFinished) { return false; }
+        job->thread.join();
+        return true;
+    });
+    return decodeJobs_.emplace_back(std::make_shared<DecodeJob>());
+}
+
+void CompositionManager::cancelDecodes() noexcept {
+    for (auto &job : decodeJobs_) { job->isCancelled = true; }
+}
+
+void CompositionManager::startFullResolutionDecode() noexcept {
+    if (!composition_->inputImage.isReduced) { return; }
+    Path path = *composition_->inputImage.filePath;
+    auto job = addDecodeJob();
+    job->thread = std::thread([this, job, path] {
+        auto result = readImageBufFromFile<F32>(path,
+                                                ImageReadOptions { .halfSize = false, .isCancelled = &job->isCancelled });
+        job->isFinished = true;
+        if (job->isCancelled) { return; }
+        if (result.hasError()) {
+            std::cerr << "[CompositionManager] Error decoding full resolution image: " << result.error().reason << "\n";
+            return;
+        }
+        auto input = std::make_shared<ImageBuf<F32>>(std::move(*result));
+        QMetaObject::invokeMethod(
+            this,
+            [this, job, input] {
+                // Another image may have been opened since the result was queued.
+                if (!job->isCancelled) { swapInFullResolution(std::move(*input)); }
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+void CompositionManager::swapInFullResolution(ImageBuf<F32> &&input) noexcept {
+    std::cerr << "[CompositionManager] Swapping in full resolution image\n";
+    composition_->inputImage.data = std::move(input);
+    composition_->inputImage.isReduced = false;
+    allocOpenCL(*composition_->inputImage.data);
+    writeToOpenCL(*composition_->inputImage.data);
+    // Keep displaying at the size the image was opened at, so that the view doesn't jump.
+    auto displaySize = displaySize_;
+    ensureOutput();
+    displaySize_ = displaySize;
+    // Masks are resolution independent, so regenerating them against the new input is enough.
+    processor_->setComposition(composition_);
+    process();
+}
+
 void CompositionManager::exportImage(const QString &qPath) noexcept {
     std::cerr << "[CompositionManager] Exporting image to: " << qPath.toStdString() << "\n";
     Path path = qPath.toStdString();
-    writeImageBufToFile(path, output_);
+    std::erase_if(exportJobs_, [](const auto &job) { return job->isFinished(); });
+    auto onFinished = [this, qPath](const ExportJob::Result &result) {
+        if (result.hasError()) {
+            std::cerr << "[CompositionManager] Error exporting image: " << result.error().reason << "\n";
+        }
+        bool isSuccess = !result.hasError();
+        QMetaObject::invokeMethod(this, [this, qPath, isSuccess] { emit imageExported(qPath, isSuccess); });
+    };
+    exportJobs_.push_back(
+        std::make_unique<ExportJob>(composition_, path, ExportOptions { defaultExportDepth(path) }, onFinished));
+}
+
+void CompositionManager::exportLut(const QString &qPath, int size) noexcept {
+    std::cerr << "[CompositionManager] Exporting LUT to: " << qPath.toStdString() << "\n";
+    std::erase_if(lutExportJobs_, [](const auto &job) { return job->isFinished(); });
+    auto onFinished = [this, qPath](const LutExportJob::Result &result) {
+        if (result.hasError()) {
+            std::cerr << "[CompositionManager] Error exporting LUT: " << result.error().reason << "\n";
+        }
+        bool isSuccess = !result.hasError();
+        QMetaObject::invokeMethod(this, [this, qPath, isSuccess] { emit lutExported(qPath, isSuccess); });
+    };
+    lutExportJobs_.push_back(std::make_unique<LutExportJob>(
+        *composition_, qPath.toStdString(), static_cast<std::size_t>(size), onFinished));
 }
 
 void CompositionManager::notifyMaskChanged(AbstractMaskGenerator *maskGen) noexcept {
-    auto &maskBuf = processor_->state.update(maskGen);
-    emit maskGenerated(maskGen, &maskBuf);
+    if ((maskGen->procedural() || maskGen->isSparse()) && !maskGen->isRefined() && !isMaskOverlayEnabled_) {
+        // Nothing needs the dense mask buffer, the processor evaluates or tiles the mask itself.
+        processor_->state.invalidate(maskGen);
+    } else {
+        auto &maskBuf = processor_->state.update(maskGen);
+        emit maskGenerated(maskGen, &maskBuf);
+    }
     process();
 }
 
@@ -103,10 +250,14 @@ void CompositionManager::ensureOutput() noexcept {
     assert(composition_);
     assert(composition_->inputImage.data);
     auto &input = *composition_->inputImage.data;
-    if (output_.width() != input.width() || output_.height() != input.height()) {
-        output_ = ImageBuf<U8> { input.width(), input.height() };
-        allocOpenCL(output_);
+    if (!output_ || output_->size != input.size) {
+        // Replace the buffer rather than resize it: the GUI may still be drawing from the old one.
+        auto output = std::make_shared<ImageBuf<U8>>(input.size);
+        allocOpenCL(*output);
+        std::lock_guard lock { outputMutex_ };
+        output_ = std::move(output);
     }
+    displaySize_ = input.size;
 }
 
 void CompositionManager::resetProcessor() noexcept {
@@ -121,8 +272,10 @@ void CompositionManager::process() noexcept {
     assert(composition_);
     assert(processor_);
     processor_->update();
-    processor_->process(output_);
+    processor_->process(*output_);
     // TODO: Read back from OpenCL here? Currently process() handles that for us.
+    waveform_.generate(*output_, scopeSamples);
+    vectorscope_.generate(*output_, scopeSamples);
     emit imageChanged();
 }
 
@@ -132,3 +285,5 @@ void CompositionManager::setFiltersEnabled(bool isEnabled) noexcept {
         process();
     }
 }
+
+void CompositionManager::setMaskOverlayEnabled(bool isEnabled) noexcept { isMaskOverlayEnabled_ = isEnabled; }
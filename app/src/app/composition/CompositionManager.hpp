@@ -1,12 +1,19 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include <QObject>
 
 #include <image/Composition.hpp>
+#include <image/ExportJob.hpp>
 #include <image/ImageBuf.hpp>
+#include <image/LutExport.hpp>
 #include <image/Processor.hpp>
+#include <image/Scopes.hpp>
 
 #include <app/composition/CompositionModel.hpp>
 
@@ -14,6 +21,7 @@ class CompositionManager final : public QObject {
     Q_OBJECT
 public:
     explicit CompositionManager(QObject *parent = nullptr) noexcept;
+    virtual ~CompositionManager() noexcept;
 
     /**
      * @brief Load the composition at path
@@ -37,12 +45,24 @@ public:
     void openImage(const QString &path) noexcept;
 
     /**
-     * @brief Export the output buffer to a file.
+     * @brief Export the composition to a file, at full resolution.
+     *
+     * The image is rendered and written in the background. imageExported() is emitted when it's done.
      *
      * @param path Where to save the image
      */
     void exportImage(const QString &path) noexcept;
 
+    /**
+     * @brief Bake the composition's unmasked layers into a LUT and write it to a .cube file or Hald image.
+     *
+     * The LUT is baked and written in the background. lutExported() is emitted when it's done.
+     *
+     * @param path Where to save the LUT
+     * @param size Lattice nodes per side
+     */
+    void exportLut(const QString &path, int size) noexcept;
+
     void notifyMaskChanged(image::AbstractMaskGenerator *maskGen) noexcept;
 
     void ensureOutput() noexcept;
@@ -51,11 +71,30 @@ public:
 
     inline std::shared_ptr<image::Composition> composition() noexcept { return composition_; }
     inline std::shared_ptr<image::Processor> processor() noexcept { return processor_; }
-    inline image::ImageBuf<image::U8> &output() noexcept { return output_; }
+    /**
+     * @brief The latest output. Safe to call from any thread: the buffer is kept alive while it's held.
+     */
+    inline std::shared_ptr<const image::ImageBuf<image::U8>> output() const noexcept {
+        std::lock_guard lock { outputMutex_ };
+        return output_;
+    }
+    /**
+     * @brief Size to display the output at. This is larger than the output while a preview is shown.
+     */
+    inline const image::ImageSize &displaySize() const noexcept { return displaySize_; }
     inline CompositionModel *compositionModel() noexcept { return compositionModel_; }
+    inline const image::Waveform &waveform() const noexcept { return waveform_; }
+    inline const image::Vectorscope &vectorscope() const noexcept { return vectorscope_; }
 
     void setFiltersEnabled(bool isEnabled) noexcept;
 
+    /**
+     * @brief Set whether generated masks are being displayed.
+     *
+     * Procedural masks are only rasterised while the overlay is enabled.
+     */
+    void setMaskOverlayEnabled(bool isEnabled) noexcept;
+
 signals:
     /**
      * @brief Emitted when the image is being loaded.
@@ -82,14 +121,78 @@ signals:
      */
     void compositionPathChanged(const QString &path);
 
+    /**
+     * @brief Emitted when an export has finished.
+     */
+    void imageExported(const QString &path, bool isSuccess);
+
+    /**
+     * @brief Emitted when a LUT export has finished.
+     */
+    void lutExported(const QString &path, bool isSuccess);
+
     /**
      * @brief Emitted when a mask has been re-generated.
      */
     void maskGenerated(const image::AbstractMaskGenerator *maskGen, const image::Mask *maskBuf);
 
 private:
+    /**
+     * @brief A decode running on a thread of its own.
+     *
+     * Opening something else cancels it rather than waiting for it: it stops at the next band, or if it's somewhere
+     * a band can't be cut short, such as LibRaw's demosaic, it runs on and its result is dropped.
+     */
+    struct DecodeJob {
+        std::thread thread;
+        std::atomic<bool> isCancelled { false };
+        std::atomic<bool> isFinished { false };
+    };
+
+    /**
+     * @brief Add a job for a new decode to start, joining the threads of any that have finished.
+     */
+    std::shared_ptr<DecodeJob> addDecodeJob() noexcept;
+
+    /**
+     * @brief Cancel every decode in progress. Returns straight away.
+     */
+    void cancelDecodes() noexcept;
+
+    /**
+     * @brief If path is a RAW file with an embedded preview, process and show that until the image is decoded.
+     */
+    void showEmbeddedPreview(const image::Path &path) noexcept;
+
+    /**
+     * @brief Show an image opened by openImage() once it's decoded, in place of its preview.
+     */
+    void finishOpeningImage(const QString &path, std::shared_ptr<image::Composition> comp) noexcept;
+
+    /**
+     * @brief If the input was opened at reduced resolution, start decoding it at full resolution in the background.
+     *
+     * The full resolution image replaces the input once it's ready, between edits.
+     */
+    void startFullResolutionDecode() noexcept;
+
+    /**
+     * @brief Replace the input with the full resolution image.
+     */
+    void swapInFullResolution(image::ImageBuf<image::F32> &&input) noexcept;
+
     std::shared_ptr<image::Composition> composition_;
     std::shared_ptr<image::Processor> processor_;
-    image::ImageBuf<image::U8> output_;
+    std::shared_ptr<image::ImageBuf<image::U8>> output_;
+    mutable std::mutex outputMutex_;
+    bool isShowingPreview_ { false };
+    image::ImageSize displaySize_;
+    image::Waveform waveform_;
+    image::Vectorscope vectorscope_;
     CompositionModel *compositionModel_ { nullptr };
+    bool isMaskOverlayEnabled_ { false };
+
+    std::vector<std::shared_ptr<DecodeJob>> decodeJobs_;
+    std::vector<std::unique_ptr<image::ExportJob>> exportJobs_;
+    std::vector<std::unique_ptr<image::LutExportJob>> lutExportJobs_;
 };
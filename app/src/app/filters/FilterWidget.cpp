@@ -109,7 +109,7 @@ LutFilterWidget::LutFilterWidget(QWidget *parent) noexcept : FilterWidget(parent
     auto fileDialog = new QFileDialog(this, "Open LUT");
     fileDialog->setAcceptMode(QFileDialog::AcceptMode::AcceptOpen);
     fileDialog->setFileMode(QFileDialog::FileMode::ExistingFile);
-    fileDialog->setNameFilter("3D LUTs (*.cube)");
+    fileDialog->setNameFilter("LUTs (*.cube *.png *.tif *.tiff)");
     fileDialog->setDirectory(QStandardPaths::writableLocation(QStandardPaths::PicturesLocation));
 
     fileChooser = new FileChooser(fileDialog, this);
@@ -2,6 +2,7 @@
 
 #include <QDebug>
 
+#include <app/canvas/BrushControl.hpp>
 #include <app/canvas/LinearGradientControl.hpp>
 
 using namespace image;
@@ -27,6 +28,22 @@ void MaskManager::activateControls() noexcept {
             emit maskUpdated();
         });
         ctrl_ = std::move(ctrl);
+    } else if (maskGen_->getMeta().id == "maskGenerators.brush") {
+        auto gen = static_cast<BrushMaskGenerator *>(maskGen_);
+        auto ctrl = std::make_unique<BrushControl>(scene_, this);
+        connect(ctrl.get(), &BrushControl::strokeStarted, this, [this, gen](const QPointF &pos, bool erase) {
+            BrushStroke stroke;
+            stroke.erase = erase;
+            stroke.points.push_back(glm::vec2 { pos.x(), pos.y() });
+            gen->strokes.push_back(std::move(stroke));
+            emit maskUpdated();
+        });
+        connect(ctrl.get(), &BrushControl::strokeExtended, this, [this, gen](const QPointF &pos) {
+            if (gen->strokes.empty()) { return; }
+            gen->strokes.back().points.push_back(glm::vec2 { pos.x(), pos.y() });
+            emit maskUpdated();
+        });
+        ctrl_ = std::move(ctrl);
     }
 }
 
@@ -57,7 +74,7 @@ void MaskManager::setOverlayEnabled(bool isEnabled) noexcept {
 
     if (!maskGen_) { return; }
 
-    if (isOverlayEnabled_ && maskBuf_) { overlay_->setMask(*maskBuf_); }
+    if (isOverlayEnabled_ && maskBuf_) { overlay_->setMask(*maskBuf_, maskGen_->resolutionDivisor()); }
 }
 
 void MaskManager::createOverlay() noexcept {
@@ -71,7 +88,7 @@ void MaskManager::handleMaskGenerated(const image::AbstractMaskGenerator *maskGe
     maskBuf_ = maskBuf;
     if (isOverlayEnabled_) {
         if (maskGen_) {
-            overlay_->setMask(*maskBuf_);
+            overlay_->setMask(*maskBuf_, maskGen_->resolutionDivisor());
         } else {
             overlay_->clearMask();
         }
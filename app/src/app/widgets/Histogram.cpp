@@ -8,8 +8,8 @@ Histogram::Histogram(QWidget *parent) noexcept : QWidget(parent) {
     histogram_.generateTest();
 }
 
-void Histogram::generate(const image::ImageBuf<image::U8, image::RGB> &img) noexcept {
-    histogram_.generate(img);
+void Histogram::setHistogram(const image::Histogram<> &histogram) noexcept {
+    histogram_ = histogram;
     update();
 }
 
@@ -39,7 +39,7 @@ void Histogram::paintEvent(QPaintEvent *) {
     QPainterPath redPath(rect().bottomLeft());
     for (image::memory::Size i = 0; i < histogram_.numBuckets(); i++) {
         auto barHeight = (1 - histogram_.red[i]) * widgetHeight;
-        redPath.lineTo(i * widgetWidth / 256, barHeight);
+        redPath.lineTo(i * widgetWidth / histogram_.numBuckets(), barHeight);
     }
     redPath.lineTo(widgetWidth, widgetHeight);
     painter.fillPath(redPath, redBrush);
@@ -54,7 +54,7 @@ void Histogram::paintEvent(QPaintEvent *) {
     QPainterPath greenPath(rect().bottomLeft());
     for (image::memory::Size i = 0; i < histogram_.numBuckets(); i++) {
         auto barHeight = (1 - histogram_.green[i]) * widgetHeight;
-        greenPath.lineTo(i * widgetWidth / 256, barHeight);
+        greenPath.lineTo(i * widgetWidth / histogram_.numBuckets(), barHeight);
     }
     greenPath.lineTo(widgetWidth, widgetHeight);
     painter.fillPath(greenPath, greenBrush);
@@ -69,7 +69,7 @@ void Histogram::paintEvent(QPaintEvent *) {
     QPainterPath bluePath(rect().bottomLeft());
     for (image::memory::Size i = 0; i < histogram_.numBuckets(); i++) {
         auto barHeight = (1 - histogram_.blue[i]) * widgetHeight;
-        bluePath.lineTo(i * widgetWidth / 256, barHeight);
+        bluePath.lineTo(i * widgetWidth / histogram_.numBuckets(), barHeight);
     }
     bluePath.lineTo(widgetWidth, widgetHeight);
     painter.fillPath(bluePath, blueBrush);
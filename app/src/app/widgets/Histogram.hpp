@@ -11,7 +11,7 @@ public:
 
     virtual ~Histogram() {}
 
-    void generate(const image::ImageBuf<image::U8, image::RGB> &img) noexcept;
+    void setHistogram(const image::Histogram<> &histogram) noexcept;
 
     QSize sizeHint() const override;
     QSize minimumSizeHint() const override;
@@ -20,5 +20,5 @@ protected:
     virtual void paintEvent(QPaintEvent *event) override;
 
 private:
-    image::Histogram<image::U8> histogram_;
+    image::Histogram<> histogram_;
 };
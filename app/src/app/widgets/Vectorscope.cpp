@@ -0,0 +1,40 @@
+#include <app/widgets/Vectorscope.hpp>
+
+#include <algorithm>
+
+#include <QPainter>
+
+Vectorscope::Vectorscope(QWidget *parent) noexcept
+  : QWidget(parent)
+  , image_(image::Vectorscope::SIZE, image::Vectorscope::SIZE, QImage::Format_Grayscale8) {
+    setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Minimum);
+    image_.fill(Qt::black);
+}
+
+void Vectorscope::setVectorscope(const image::Vectorscope &vectorscope) noexcept {
+    // Cr increases upwards.
+    for (image::memory::Size v = 0; v < image::Vectorscope::SIZE; ++v) {
+        auto line = image_.scanLine(image::Vectorscope::SIZE - 1 - v);
+        for (image::memory::Size u = 0; u < image::Vectorscope::SIZE; ++u) {
+            line[u] = static_cast<uchar>(vectorscope.density.at(u, v) * 255);
+        }
+    }
+    update();
+}
+
+QSize Vectorscope::sizeHint() const { return QSize(256, 256); }
+QSize Vectorscope::minimumSizeHint() const { return QSize(150, 150); }
+
+void Vectorscope::paintEvent(QPaintEvent *) {
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::black);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+
+    // Keep the scope square and centred.
+    auto side = std::min(width(), height());
+    QRect target { (width() - side) / 2, (height() - side) / 2, side, side };
+    painter.drawImage(target, image_);
+    painter.setPen(QColor::fromRgbF(0.4, 0.4, 0.4));
+    painter.drawLine(target.center().x(), target.top(), target.center().x(), target.bottom());
+    painter.drawLine(target.left(), target.center().y(), target.right(), target.center().y());
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <QImage>
+#include <QWidget>
+
+#include <image/Scopes.hpp>
+
+class Vectorscope : public QWidget {
+    Q_OBJECT
+public:
+    explicit Vectorscope(QWidget *parent = nullptr) noexcept;
+
+    virtual ~Vectorscope() {}
+
+    void setVectorscope(const image::Vectorscope &vectorscope) noexcept;
+
+    QSize sizeHint() const override;
+    QSize minimumSizeHint() const override;
+
+protected:
+    virtual void paintEvent(QPaintEvent *event) override;
+
+private:
+    QImage image_;
+};
@@ -0,0 +1,32 @@
+#include <app/widgets/Waveform.hpp>
+
+#include <QPainter>
+
+Waveform::Waveform(QWidget *parent) noexcept
+  : QWidget(parent)
+  , image_(image::Waveform::NUM_COLUMNS, image::Waveform::NUM_LEVELS, QImage::Format_RGB32) {
+    setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Minimum);
+    image_.fill(Qt::black);
+}
+
+void Waveform::setWaveform(const image::Waveform &waveform) noexcept {
+    // Channels are drawn additively, with the highest level at the top.
+    for (image::memory::Size level = 0; level < image::Waveform::NUM_LEVELS; ++level) {
+        auto line = reinterpret_cast<QRgb *>(image_.scanLine(image::Waveform::NUM_LEVELS - 1 - level));
+        for (image::memory::Size x = 0; x < image::Waveform::NUM_COLUMNS; ++x) {
+            line[x] = qRgb(static_cast<int>(waveform.density.at(0, x, level) * 255),
+                           static_cast<int>(waveform.density.at(1, x, level) * 255),
+                           static_cast<int>(waveform.density.at(2, x, level) * 255));
+        }
+    }
+    update();
+}
+
+QSize Waveform::sizeHint() const { return QSize(256, 150); }
+QSize Waveform::minimumSizeHint() const { return QSize(256, 150); }
+
+void Waveform::paintEvent(QPaintEvent *) {
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    painter.drawImage(rect(), image_);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <QImage>
+#include <QWidget>
+
+#include <image/Scopes.hpp>
+
+class Waveform : public QWidget {
+    Q_OBJECT
+public:
+    explicit Waveform(QWidget *parent = nullptr) noexcept;
+
+    virtual ~Waveform() {}
+
+    void setWaveform(const image::Waveform &waveform) noexcept;
+
+    QSize sizeHint() const override;
+    QSize minimumSizeHint() const override;
+
+protected:
+    virtual void paintEvent(QPaintEvent *event) override;
+
+private:
+    QImage image_;
+};
@@ -0,0 +1,54 @@
+#include <memory>
+#include <optional>
+
+#include <benchmark/benchmark.h>
+
+#include <image/Composition.hpp>
+#include <image/CoreTypes.hpp>
+#include <image/Filters.hpp>
+#include <image/ImageBuf.hpp>
+#include <image/Processor.hpp>
+#include <image/opencl/Manager.hpp>
+
+#include "CompositionFixture.hpp"
+
+using namespace image;
+
+class ApplyLutFixture : public CompositionFixture {
+public:
+    void SetUp(const benchmark::State &state) override {
+        CompositionFixture::SetUp(state);
+
+        auto layer = std::make_shared<Layer>();
+        auto saturation = std::make_unique<SaturationFilterSpec>();
+        saturation->multiplier = 1.5f;
+        layer->filters->addFilter(std::move(saturation));
+        composition->layers.push_back(layer);
+    }
+
+    void run(benchmark::State &state, LutStorage storage) {
+        Processor processor { storage };
+        processor.init();
+        processor.setComposition(composition);
+        processor.update();
+        for (auto _ : state) {
+            std::optional<PoolLease<ImageBuf<F32>>> lease;
+            processor.render(lease);
+            clFinish(opencl::Manager::the()->queue.getHandle().get());
+        }
+    }
+};
+
+BENCHMARK_DEFINE_F(ApplyLutFixture, image)(benchmark::State &state) {
+    if (!opencl::Manager::the()->context.getDevice().imageSupport) {
+        state.SkipWithError("Device doesn't support images");
+        return;
+    }
+    run(state, LutStorage::Image);
+}
+BENCHMARK_REGISTER_F(ApplyLutFixture, image)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_DEFINE_F(ApplyLutFixture, buffer)(benchmark::State &state) { run(state, LutStorage::Buffer); }
+BENCHMARK_REGISTER_F(ApplyLutFixture, buffer)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
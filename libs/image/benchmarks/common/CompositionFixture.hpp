@@ -0,0 +1,35 @@
+#pragma once
+
+#include <memory>
+#include <random>
+
+#include <benchmark/benchmark.h>
+
+#include <image/Composition.hpp>
+#include <image/CoreTypes.hpp>
+#include <image/ImageBuf.hpp>
+#include <image/opencl/Manager.hpp>
+
+/**
+ * @brief An OpenCL manager and a composition editing a 6000x4000 image of noise, with no layers.
+ */
+class CompositionFixture : public benchmark::Fixture {
+public:
+    std::unique_ptr<image::opencl::Manager> manager;
+    std::shared_ptr<image::Composition> composition;
+
+    void SetUp(const benchmark::State &) override {
+        manager = std::make_unique<image::opencl::Manager>();
+        composition = std::make_shared<image::Composition>();
+        image::ImageBuf<image::F32> image { 6000, 4000 };
+        std::mt19937 rng { 1 };
+        std::uniform_real_distribution<image::F32> dist { 0.0f, 1.0f };
+        for (auto &value : image.pixelArray) { value = dist(rng); }
+        composition->inputImage.data = std::move(image);
+    }
+
+    void TearDown(const benchmark::State &) override {
+        composition = nullptr;
+        manager = nullptr;
+    }
+};
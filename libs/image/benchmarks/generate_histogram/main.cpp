@@ -0,0 +1,80 @@
+#include <array>
+#include <random>
+
+#include <benchmark/benchmark.h>
+
+#include <image/CoreTypes.hpp>
+#include <image/Histogram.hpp>
+#include <image/ImageBuf.hpp>
+
+using namespace image;
+
+class HistogramFixture : public benchmark::Fixture {
+public:
+    ImageBuf<U8> image { 6000, 4000 };
+    ImageBuf<F32> imageF32 { 6000, 4000 };
+
+    void SetUp(const benchmark::State &) {
+        std::mt19937 rng { 1 };
+        std::uniform_real_distribution<F32> dist { 0.0f, 1.0f };
+        for (memory::Size y = 0; y < image.height(); ++y) {
+            for (memory::Size i = 0; i < 3 * image.width(); ++i) {
+                auto value = dist(rng);
+                imageF32.row(y)[i] = value;
+                image.row(y)[i] = conv<U8, F32>(value);
+            }
+        }
+    }
+
+    void TearDown(const benchmark::State &) {}
+};
+
+void generate_sequential(const ImageBuf<U8> &img, std::array<U32, 3 * 256> &bins) noexcept {
+    bins.fill(0);
+    for (memory::Size y = 0; y < img.height(); ++y) {
+        const U8 *data = img.row(y);
+        for (memory::Size i = 0; i < img.width(); ++i) {
+            bins[data[3 * i]]++;
+            bins[256 + data[3 * i + 1]]++;
+            bins[512 + data[3 * i + 2]]++;
+        }
+    }
+}
+
+BENCHMARK_DEFINE_F(HistogramFixture, sequential)(benchmark::State &state) {
+    std::array<U32, 3 * 256> bins;
+    for (auto _ : state) {
+        generate_sequential(image, bins);
+        benchmark::DoNotOptimize(bins);
+    }
+}
+BENCHMARK_REGISTER_F(HistogramFixture, sequential)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_DEFINE_F(HistogramFixture, private_bins_U8_256)(benchmark::State &state) {
+    Histogram<256> histogram;
+    for (auto _ : state) {
+        histogram.generate(image, state.range(0));
+        benchmark::DoNotOptimize(histogram);
+    }
+}
+BENCHMARK_REGISTER_F(HistogramFixture, private_bins_U8_256)->Arg(1)->Arg(4)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_DEFINE_F(HistogramFixture, private_bins_F32_1024)(benchmark::State &state) {
+    Histogram<1024> histogram;
+    for (auto _ : state) {
+        histogram.generate(imageF32, state.range(0));
+        benchmark::DoNotOptimize(histogram);
+    }
+}
+BENCHMARK_REGISTER_F(HistogramFixture, private_bins_F32_1024)->Arg(1)->Arg(4)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_DEFINE_F(HistogramFixture, private_bins_F32_4096)(benchmark::State &state) {
+    Histogram<4096> histogram;
+    for (auto _ : state) {
+        histogram.generate(imageF32, state.range(0));
+        benchmark::DoNotOptimize(histogram);
+    }
+}
+BENCHMARK_REGISTER_F(HistogramFixture, private_bins_F32_4096)->Arg(1)->Arg(4)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,72 @@
+#include <random>
+
+#include <benchmark/benchmark.h>
+
+#include <image/CoreTypes.hpp>
+#include <image/Histogram.hpp>
+#include <image/ImageBuf.hpp>
+
+using namespace image;
+
+// An odd width, as after a crop, so that packed rows don't happen to start on cache lines.
+constexpr memory::Size width = 5473;
+constexpr memory::Size height = 3648;
+
+template <ChannelsSpec Channels>
+void fill(ImageBuf<F32, Channels> &image) noexcept {
+    constexpr memory::Size n = Channels::numChannels();
+    std::mt19937 rng { 1 };
+    std::uniform_real_distribution<F32> dist { 0.0f, 1.0f };
+    for (memory::Size y = 0; y < height; ++y) {
+        F32 *row = image.row(y);
+        for (memory::Size i = 0; i < n * width; ++i) { row[i] = i % n < 3 ? dist(rng) : 0.0f; }
+    }
+}
+
+/**
+ * @brief A 3x3 colour matrix over a row, the shape of a saturation op. The X channel is carried through.
+ */
+template <ChannelsSpec Channels>
+void transformRow(const F32 *in, F32 *out, const F32 (&m)[9]) noexcept {
+    constexpr memory::Size n = Channels::numChannels();
+    for (memory::Size x = 0; x < width; ++x) {
+        const F32 *p = in + n * x;
+        F32 *q = out + n * x;
+        q[0] = m[0] * p[0] + m[1] * p[1] + m[2] * p[2];
+        q[1] = m[3] * p[0] + m[4] * p[1] + m[5] * p[2];
+        q[2] = m[6] * p[0] + m[7] * p[1] + m[8] * p[2];
+        if constexpr (n == 4) { q[3] = p[3]; }
+    }
+}
+
+template <ChannelsSpec Channels, RowLayout Layout>
+void transform(benchmark::State &state) {
+    ImageBuf<F32, Channels> in { width, height, Layout };
+    ImageBuf<F32, Channels> out { width, height, Layout };
+    fill(in);
+    const F32 matrix[9] = { 1.4f, -0.3f, -0.1f, -0.2f, 1.3f, -0.1f, -0.2f, -0.3f, 1.5f };
+    for (auto _ : state) {
+        for (memory::Size y = 0; y < height; ++y) { transformRow<Channels>(in.row(y), out.row(y), matrix); }
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * 2 * height * in.rowPitchBytes());
+}
+BENCHMARK_TEMPLATE(transform, RGB, RowLayout::Packed)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(transform, RGB, RowLayout::Aligned)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(transform, RGBX, RowLayout::Aligned)->Unit(benchmark::kMillisecond);
+
+template <RowLayout Layout>
+void histogram(benchmark::State &state) {
+    ImageBuf<F32> image { width, height, Layout };
+    fill(image);
+    Histogram<1024> histogram;
+    for (auto _ : state) {
+        histogram.generate(image);
+        benchmark::DoNotOptimize(histogram);
+    }
+}
+BENCHMARK_TEMPLATE(histogram, RowLayout::Packed)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(histogram, RowLayout::Aligned)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,80 @@
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+#include <benchmark/benchmark.h>
+
+#include <image/CoreTypes.hpp>
+#include <image/luts/BinaryCube.hpp>
+#include <image/luts/CubeFile.hpp>
+
+using namespace image;
+
+class CubeFileFixture : public benchmark::Fixture {
+public:
+    constexpr static const std::size_t SIZE { 65 };
+
+    String text;
+    Path sourcePath { std::filesystem::temp_directory_path() / "libimage_benchmark_parse_cube_file.cube" };
+    Path binaryPath { std::filesystem::temp_directory_path() / "libimage_benchmark_parse_cube_file.lutcache" };
+
+    void SetUp(const benchmark::State &) {
+        std::mt19937 rng { 1 };
+        std::uniform_real_distribution<F32> dist { 0.0f, 1.0f };
+        std::ostringstream stream;
+        stream << "TITLE \"Benchmark\"\nLUT_3D_SIZE " << SIZE << "\n";
+        for (std::size_t i = 0; i < SIZE * SIZE * SIZE; ++i) {
+            stream << dist(rng) << " " << dist(rng) << " " << dist(rng) << "\n";
+        }
+        text = stream.str();
+        std::ofstream(sourcePath, std::ios::binary) << text;
+    }
+
+    void TearDown(const benchmark::State &) {
+        std::filesystem::remove(sourcePath);
+        std::filesystem::remove(binaryPath);
+    }
+};
+
+void parse_stream(std::istream &stream, NDArray<ColorRGB<F32>> &table) noexcept {
+    String field;
+    std::size_t size = 0;
+    while (stream >> field && field != "LUT_3D_SIZE") {}
+    stream >> size;
+    table = NDArray<ColorRGB<F32>>(Shape { size, size, size });
+    for (auto &color : table) { stream >> color.r >> color.g >> color.b; }
+}
+
+BENCHMARK_DEFINE_F(CubeFileFixture, stream_extraction)(benchmark::State &state) {
+    NDArray<ColorRGB<F32>> table { Shape {} };
+    for (auto _ : state) {
+        std::istringstream stream(text);
+        parse_stream(stream, table);
+        benchmark::DoNotOptimize(table.data());
+    }
+}
+BENCHMARK_REGISTER_F(CubeFileFixture, stream_extraction)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_DEFINE_F(CubeFileFixture, parse)(benchmark::State &state) {
+    for (auto _ : state) {
+        auto cube = luts::CubeFile::parse(text);
+        benchmark::DoNotOptimize(cube);
+    }
+}
+BENCHMARK_REGISTER_F(CubeFileFixture, parse)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_DEFINE_F(CubeFileFixture, read_binary_cube)(benchmark::State &state) {
+    auto stamp = *luts::SourceStamp::of(sourcePath);
+    if (!luts::writeBinaryCube(binaryPath, *luts::CubeFile::parse(text), sourcePath, stamp).hasError()) {
+        for (auto _ : state) {
+            auto cube = luts::readBinaryCube(binaryPath, sourcePath, stamp);
+            benchmark::DoNotOptimize(cube);
+        }
+    } else {
+        state.SkipWithError("Failed to write binary cube");
+    }
+}
+BENCHMARK_REGISTER_F(CubeFileFixture, read_binary_cube)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
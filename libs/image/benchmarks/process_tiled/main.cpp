@@ -0,0 +1,53 @@
+#include <memory>
+
+#include <benchmark/benchmark.h>
+
+#include <image/Composition.hpp>
+#include <image/CoreTypes.hpp>
+#include <image/Filters.hpp>
+#include <image/ImageBuf.hpp>
+#include <image/Mask.hpp>
+#include <image/Processor.hpp>
+#include <image/opencl/Manager.hpp>
+
+#include "CompositionFixture.hpp"
+
+using namespace image;
+
+class ProcessFixture : public CompositionFixture {
+public:
+    void run(benchmark::State &state, bool isTiledOnHost) {
+        // Each masked layer is an op of its own.
+        auto numOps = state.range(0);
+        composition->layers.clear();
+        for (I64 i = 0; i < numOps; ++i) {
+            auto layer = std::make_shared<Layer>();
+            auto saturation = std::make_unique<SaturationFilterSpec>();
+            saturation->multiplier = 1.1f;
+            layer->filters->addFilter(std::move(saturation));
+            layer->maskGen = std::make_shared<LinearGradientMaskSpec>(glm::vec2 { 0.0f, 0.1f * static_cast<F32>(i) },
+                                                                      glm::vec2 { 1.0f, 1.0f });
+            composition->layers.push_back(layer);
+        }
+
+        Processor processor { defaultLutStorage(), isTiledOnHost };
+        processor.init();
+        processor.setComposition(composition);
+        processor.update();
+        ImageBuf<U8> out { composition->inputImage.data->width(), composition->inputImage.data->height() };
+        out.pixelArray.buffer()->setDevice(opencl::Manager::the()->bufferDevice);
+        out.pixelArray.buffer()->deviceMalloc();
+        for (auto _ : state) { processor.process(out); }
+        // One pass over memory: reading the input and writing the output.
+        auto pixels = static_cast<I64>(out.width() * out.height());
+        state.SetBytesProcessed(state.iterations() * pixels * static_cast<I64>(3 * sizeof(F32) + 3 * sizeof(U8)));
+    }
+};
+
+BENCHMARK_DEFINE_F(ProcessFixture, kernels)(benchmark::State &state) { run(state, false); }
+BENCHMARK_REGISTER_F(ProcessFixture, kernels)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_DEFINE_F(ProcessFixture, tiled)(benchmark::State &state) { run(state, true); }
+BENCHMARK_REGISTER_F(ProcessFixture, tiled)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
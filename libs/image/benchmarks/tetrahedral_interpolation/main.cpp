@@ -0,0 +1,63 @@
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <image/Color.hpp>
+#include <image/CoreTypes.hpp>
+#include <image/luts/Lattice3D.hpp>
+#include <image/luts/TetrahedralInterpolator.hpp>
+
+using namespace image;
+
+class InterpolatorFixture : public benchmark::Fixture {
+public:
+    constexpr static const std::size_t LATTICE_SIZE { 33 };
+    constexpr static const memory::Size NUM_COLORS { 4 * 1024 * 1024 };
+
+    luts::TetrahedralInterpolator interpolator;
+    std::vector<ColorRGB<F32>> in;
+    std::vector<ColorRGB<F32>> out;
+
+    void SetUp(const benchmark::State &) {
+        luts::Lattice3D lattice(LATTICE_SIZE);
+        lattice.fromFunction([](const ColorRGB<F32> &color) {
+            return ColorRGB<F32> { std::sqrt(color.r), color.g * color.g, 1.0f - color.b };
+        });
+        interpolator.load(lattice);
+
+        std::mt19937 rng { 1 };
+        std::uniform_real_distribution<F32> dist { 0.0f, 1.0f };
+        in.resize(NUM_COLORS);
+        out.resize(NUM_COLORS);
+        for (auto &color : in) { color = ColorRGB<F32> { dist(rng), dist(rng), dist(rng) }; }
+    }
+
+    void TearDown(const benchmark::State &) {
+        in.clear();
+        out.clear();
+    }
+};
+
+BENCHMARK_DEFINE_F(InterpolatorFixture, map_single)(benchmark::State &state) {
+    for (auto _ : state) {
+        for (memory::Size i = 0; i < NUM_COLORS; ++i) { out[i] = interpolator.map(in[i]); }
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * NUM_COLORS);
+}
+BENCHMARK_REGISTER_F(InterpolatorFixture, map_single)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_DEFINE_F(InterpolatorFixture, map_batched)(benchmark::State &state) {
+    for (auto _ : state) {
+        interpolator.map(in.data(), out.data(), NUM_COLORS);
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * NUM_COLORS);
+}
+BENCHMARK_REGISTER_F(InterpolatorFixture, map_batched)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
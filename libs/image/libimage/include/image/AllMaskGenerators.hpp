@@ -20,6 +20,7 @@ namespace image {
 
         registerMaskGenerator<LinearGradientMaskSpec>(reg);
         registerMaskGenerator<LumaMaskGenerator>(reg);
+        registerMaskGenerator<BrushMaskGenerator>(reg);
 
         return reg;
     }
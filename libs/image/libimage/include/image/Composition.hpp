@@ -29,6 +29,11 @@ namespace image {
         std::shared_ptr<AbstractMaskGenerator> maskGen;
         bool isEnabled { true };
 
+        /**
+         * @brief Whether the layer only applies to part of the image.
+         */
+        bool hasActiveMask() const noexcept { return maskGen && maskGen->isEnabled; }
+
         Layer() : filters(std::make_shared<Filters>()) {}
     };
 
@@ -36,7 +41,13 @@ namespace image {
         std::vector<std::shared_ptr<Layer>> layers;
         ImageResource inputImage;
 
-        static Expected<Composition, CompositionCreationError> newFromPath(const Path &path) noexcept;
+        /**
+         * @brief Create a composition editing the image at path. If device is given the image is uploaded to it.
+         */
+        static Expected<Composition, CompositionCreationError>
+        newFromPath(const Path &path,
+                    std::shared_ptr<memory::AbstractDevice> device = nullptr,
+                    const ImageReadOptions &opts = ImageReadOptions()) noexcept;
     };
 
     void dumpComp(Composition &comp);
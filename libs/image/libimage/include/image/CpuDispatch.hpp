@@ -0,0 +1,20 @@
+#pragma once
+
+/**
+ * @file
+ * @brief Runtime selection of the instruction set hot CPU loops run with.
+ *
+ * libimage is built for the baseline of its target, so that one binary runs on any machine. Functions declared with
+ * IMAGE_CPU_DISPATCH are also compiled for SSE4.2, AVX2 and AVX-512, and the dynamic loader calls a resolver, which
+ * checks CPUID, to bind them to the best version the CPU supports before anything runs. Only the function's own body,
+ * and whatever is inlined into it, gets the wider instructions, so it should be a whole loop rather than a lambda
+ * handed to something else. Function templates can't be dispatched this way on every compiler.
+ *
+ * Needs ifunc support, so elsewhere, such as MSVC or macOS, this is empty and the baseline version is all there is.
+ */
+
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__ELF__)
+#define IMAGE_CPU_DISPATCH __attribute__((target_clones("avx512f", "avx2", "sse4.2", "default")))
+#else
+#define IMAGE_CPU_DISPATCH
+#endif
@@ -125,7 +125,7 @@ namespace image {
     class Expected<void, E> {
     public:
         constexpr const E& error() const {
-            assert(!error_.has_value());
+            assert(error_.has_value());
             return *error_;
         }
         bool hasError() const noexcept { return error_.has_value(); }
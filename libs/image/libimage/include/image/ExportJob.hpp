@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+
+#include <image/Composition.hpp>
+#include <image/CoreTypes.hpp>
+#include <image/Expected.hpp>
+#include <image/IO.hpp>
+
+namespace image {
+
+    /**
+     * @brief Bit depth of exported images.
+     */
+    enum class ExportDepth { U8, U16, F32 };
+
+    /**
+     * @brief The deepest format path's file type is commonly used with: float for EXR, 16-bit for TIFF and PNG.
+     */
+    ExportDepth defaultExportDepth(const Path &path) noexcept;
+
+    struct ExportOptions {
+        ExportDepth depth { ExportDepth::U8 };
+    };
+
+    /**
+     * @brief Renders a composition at full resolution and writes it to a file on a thread of its own.
+     *
+     * The job has its own Processor, so interactive processing carries on while it runs. The output is read back
+     * from the device a band of rows at a time, and each band is encoded while the next is being read back.
+     */
+    class ExportJob {
+    public:
+        using Result = Expected<void, ImageIOError>;
+        /// Called on the job's thread once it's done.
+        using FinishedCallback = std::function<void(const Result &)>;
+
+        /// Rows read back and written at a time.
+        constexpr static const memory::Size BAND_HEIGHT { 256 };
+
+        /**
+         * @brief Start exporting. If the composition's input is reduced, the job first decodes it at full resolution.
+         *
+         * The composition is copied before this returns, so call it from the thread that edits the composition.
+         */
+        ExportJob(std::shared_ptr<Composition> composition,
+                  const Path &path,
+                  const ExportOptions &opts,
+                  FinishedCallback onFinished = nullptr) noexcept;
+        ~ExportJob() noexcept;
+
+        ExportJob(const ExportJob &) = delete;
+        ExportJob &operator=(const ExportJob &) = delete;
+
+        /**
+         * @brief Fraction of the image written so far.
+         */
+        F32 progress() const noexcept { return progress_; }
+
+        bool isFinished() const noexcept { return isFinished_; }
+
+    private:
+        std::shared_ptr<Composition> composition;
+        Path path;
+        ExportOptions opts;
+        FinishedCallback onFinished;
+        std::atomic<F32> progress_ { 0.0f };
+        std::atomic<bool> isFinished_ { false };
+        std::thread thread;
+
+        Result run() noexcept;
+    };
+
+}
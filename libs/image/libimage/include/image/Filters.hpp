@@ -7,6 +7,7 @@
 #include <image/Mask.hpp>
 #include <image/PolyVal.hpp>
 #include <image/Resource.hpp>
+#include <image/luts/Lattice1D.hpp>
 #include <image/luts/Lattice3D.hpp>
 #include <image/luts/TetrahedralInterpolator.hpp>
 
@@ -22,12 +23,20 @@ namespace image {
 
         virtual const FilterMeta &getMeta() const noexcept = 0;
 
+        /**
+         * @brief Whether the filter treats each channel independently, so that it can be applied to curves.
+         */
         virtual bool isSeparable() const noexcept { return false; }
         virtual bool isLinear() const noexcept { return false; }
 
         virtual void update() noexcept {}
 
         virtual void apply(luts::Lattice3D &lattice) const noexcept = 0;
+
+        /**
+         * @brief Apply the filter to per-channel curves. Only called for separable filters.
+         */
+        virtual void applyCurves(luts::Lattice1D &) const noexcept {}
     };
 
     // FilterSpec is a value containing any filter spec implementation.
@@ -46,19 +55,21 @@ namespace image {
         virtual bool isLinear() const noexcept override { return true; }
 
         virtual void apply(luts::Lattice3D &lattice) const noexcept override;
+        virtual void applyCurves(luts::Lattice1D &curves) const noexcept override;
     };
 
     struct LutFilterSpec final : AbstractFilterSpec {
         LutResource lut;
         F32 strength { 1.0f };
 
-        luts::TetrahedralInterpolator interp;
-
-        static inline FilterMeta meta { "filters.lut", "3D LUT" };
+        static inline FilterMeta meta { "filters.lut", "LUT" };
 
         virtual const FilterMeta &getMeta() const noexcept override { return meta; }
+        /// 1D LUTs are separable, as is having no LUT loaded.
+        virtual bool isSeparable() const noexcept override { return !lut.data || lut.data->isSeparable(); }
         virtual void update() noexcept override;
         virtual void apply(luts::Lattice3D &lattice) const noexcept override;
+        virtual void applyCurves(luts::Lattice1D &curves) const noexcept override;
     };
 
     struct SaturationFilterSpec final : AbstractFilterSpec {
@@ -76,7 +87,9 @@ namespace image {
         static inline FilterMeta meta { "filters.contrast", "Contrast" };
 
         virtual const FilterMeta &getMeta() const noexcept override { return meta; }
+        virtual bool isSeparable() const noexcept override { return true; }
         virtual void apply(luts::Lattice3D &lattice) const noexcept override;
+        virtual void applyCurves(luts::Lattice1D &curves) const noexcept override;
     };
 
     struct ChannelMixerFilterSpec final : AbstractFilterSpec {
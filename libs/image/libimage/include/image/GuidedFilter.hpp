@@ -0,0 +1,59 @@
+#pragma once
+
+#include <image/CoreTypes.hpp>
+#include <image/ImageBuf.hpp>
+#include <image/Mask.hpp>
+#include <image/NDArray.hpp>
+#include <image/opencl/Program.hpp>
+
+namespace image {
+
+    /**
+     * @brief Refine mask in place with a guided filter, using the luma of img as the guide.
+     *
+     * This is the fast guided filter: the linear coefficients are found at a lower resolution and upsampled, and all
+     * the means use running-sum box filters, so the cost doesn't depend on the radius. Radius is in mask pixels, and
+     * divisor is the mask generator's resolutionDivisor().
+     */
+    void guidedFilterHost(const ImageBuf<F32> &img,
+                          Mask &mask,
+                          memory::Size divisor,
+                          memory::Size radius,
+                          F32 epsilon) noexcept;
+
+    /**
+     * @brief OpenCL implementation of guidedFilterHost(). img must already be on the device.
+     *
+     * Scratch buffers are kept between calls, so reusing one instance for masks of the same size avoids allocations.
+     */
+    class GuidedFilter {
+    public:
+        void apply(const ImageBuf<F32> &img,
+                   Mask &mask,
+                   memory::Size divisor,
+                   memory::Size radius,
+                   F32 epsilon) noexcept;
+
+        GuidedFilter() noexcept;
+
+    private:
+        opencl::Program oclProgram;
+        opencl::Kernel oclKernelGuide;
+        opencl::Kernel oclKernelDownsample;
+        opencl::Kernel oclKernelBoxRows;
+        opencl::Kernel oclKernelBoxColumns;
+        opencl::Kernel oclKernelCoefficients;
+        opencl::Kernel oclKernelOutput;
+
+        ImageSize maskSize;
+        ImageSize lowSize;
+        Mask deviceMask;
+        Mask guide;
+        /// Shape: {4, lowSize.x, lowSize.y}.
+        NDArray<F32> stats;
+        NDArray<F32> scratch;
+
+        void allocate(const ImageSize &size, memory::Size subsampling) noexcept;
+    };
+
+}
@@ -3,58 +3,156 @@
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <concepts>
 #include <limits>
+#include <vector>
 
 #include <image/Color.hpp>
 #include <image/CoreTypes.hpp>
 #include <image/ImageBuf.hpp>
 #include <image/NDArray.hpp>
+#include <image/TaskGraph.hpp>
 
 namespace image {
 
-    template <class I>
+    namespace detail {
+        /**
+         * @brief Bin indices of count RGB pixels, stride pixels apart, into histogram bins of numBuckets a channel.
+         *
+         * This is Histogram::bucket() for a whole run of pixels, compiled for the CPU's widest vectors.
+         */
+        void bucketIndices(const F32 *pixels,
+                           memory::Size count,
+                           memory::Size stride,
+                           memory::Size numBuckets,
+                           U32 *indices) noexcept;
+    }
+
+    /**
+     * @brief Per-channel histogram with N buckets.
+     *
+     * Bucket heights are normalised so that the tallest bucket, ignoring the first and last, is 1.
+     */
+    template <memory::Size N = 256>
     struct Histogram {
-        constexpr static const memory::Size NUM_BUCKETS { std::numeric_limits<I>::max() + 1 };
+        static_assert(N >= 3, "Histogram needs buckets other than the first and last to normalise against");
+
+        constexpr static const memory::Size NUM_BUCKETS { N };
 
-        std::array<F32, std::numeric_limits<I>::max() + 1> red;
-        std::array<F32, std::numeric_limits<I>::max() + 1> green;
-        std::array<F32, std::numeric_limits<I>::max() + 1> blue;
+        std::array<F32, N> red;
+        std::array<F32, N> green;
+        std::array<F32, N> blue;
 
         constexpr memory::Size numBuckets() const noexcept { return NUM_BUCKETS; }
 
+        /**
+         * @brief Bucket a channel value falls into. The whole range of integer types is spread over the buckets.
+         */
+        template <class T>
+        static constexpr U32 bucket(T value) noexcept {
+            if constexpr (std::floating_point<T>) {
+                auto scaled = std::clamp(value * static_cast<T>(N), static_cast<T>(0), static_cast<T>(N - 1));
+                return static_cast<U32>(scaled);
+            } else {
+                constexpr memory::Size range = static_cast<memory::Size>(std::numeric_limits<T>::max()) + 1;
+                return static_cast<U32>(static_cast<memory::Size>(value) * N / range);
+            }
+        }
+
+        /**
+         * @brief Pick a sampling stride so that roughly maxSamples pixels of an image are counted.
+         */
+        static memory::Size strideFor(const ImageSize &size, memory::Size maxSamples) noexcept {
+            auto ratio = static_cast<F64>(size.x * size.y) / static_cast<F64>(maxSamples);
+            return std::max<memory::Size>(static_cast<memory::Size>(std::sqrt(ratio)), 1);
+        }
+
+        /**
+         * @brief Count the values in img, looking at every stride-th pixel of every stride-th row.
+         *
+         * The rows are split into a chunk per thread, each counted into private bins, so no bins are shared while
+         * counting. The chunks are then summed pairwise in a TaskGraph, each sum starting as soon as both its chunks
+         * are ready.
+         */
         template <class T>
-        void generate(const ImageBuf<T, RGB> &img) noexcept {
-            std::array<U32, NUM_BUCKETS> ired, igreen, iblue;
-            ired.fill(0);
-            igreen.fill(0);
-            iblue.fill(0);
+        void generate(const ImageBuf<T, RGB> &img, memory::Size stride = 1) noexcept {
+            using Bins = std::array<U32, 3 * N>;
+            constexpr memory::Size block = 256;
+
+            memory::Size width = img.width();
+            memory::Size rows = (img.height() + stride - 1) / stride;
+            memory::Size columns = (width + stride - 1) / stride;
+            memory::Size numChunks =
+                std::clamp<memory::Size>(ThreadPool::shared().numThreads(), 1, std::max<memory::Size>(rows, 1));
+            std::vector<Bins> chunkBins(numChunks);
 
             // Count values.
-            const ColorRGB<T> *pixels = reinterpret_cast<const ColorRGB<T> *>(img.pixelArray.data());
-            auto numPixels = img.width() * img.height();
-            #pragma omp parallel for
-            for (memory::Size i = 0; i < numPixels; ++i) {
-                auto ipixel = conv<I, T>(pixels[i]);
-                ired[ipixel.x]++;
-                igreen[ipixel.y]++;
-                iblue[ipixel.z]++;
+            auto countChunk = [&](memory::Size c) {
+                auto &bins = chunkBins[c];
+                bins.fill(0);
+                [[maybe_unused]] std::array<U32, 3 * block> indices;
+                for (memory::Size row = c * rows / numChunks; row < (c + 1) * rows / numChunks; ++row) {
+                    const T *line = img.row(row * stride);
+                    if constexpr (std::same_as<T, F32>) {
+                        // Work out the buckets separately from counting, so that the conversions have no
+                        // dependencies and can be vectorised.
+                        for (memory::Size x0 = 0; x0 < columns; x0 += block) {
+                            memory::Size n = std::min(block, columns - x0);
+                            detail::bucketIndices(line + x0 * stride * 3, n, stride, N, indices.data());
+                            for (memory::Size i = 0; i < 3 * n; ++i) { ++bins[indices[i]]; }
+                        }
+                    } else {
+                        // Integer buckets are a shift at most, so there's nothing worth vectorising.
+                        for (memory::Size x = 0; x < columns; ++x) {
+                            const T *pixel = line + x * stride * 3;
+                            ++bins[bucket(pixel[0])];
+                            ++bins[N + bucket(pixel[1])];
+                            ++bins[2 * N + bucket(pixel[2])];
+                        }
+                    }
+                }
+            };
+            TaskGraph graph;
+            // The last task to write each chunk's bins.
+            std::vector<TaskGraph::Node> chunkTasks(numChunks);
+            for (memory::Size c = 0; c < numChunks; ++c) {
+                chunkTasks[c] = graph.add([&countChunk, c] { countChunk(c); });
             }
 
+            // Sum the chunks pairwise, ending up in the first chunk.
+            for (memory::Size step = 1; step < numChunks; step *= 2) {
+                for (memory::Size c = 0; c < numChunks - step; c += 2 * step) {
+                    auto sum = [&dst = chunkBins[c], &src = chunkBins[c + step]] {
+                        #pragma omp simd
+                        for (memory::Size i = 0; i < 3 * N; ++i) { dst[i] += src[i]; }
+                    };
+                    chunkTasks[c] = graph.add(sum, { chunkTasks[c], chunkTasks[c + step] });
+                }
+            }
+            graph.run();
+            setCounts(chunkBins.front());
+        }
+
+        /**
+         * @brief Set the buckets from raw counts: all the red buckets, then green, then blue.
+         */
+        void setCounts(const std::array<U32, 3 * N> &bins) noexcept {
             // Write to floating point output data.
             // We ignore top and bottom buckets for scaling purposes because it can throw things off when things start to clip.
-            auto maxRed = std::max_element(ired.begin() + 1, ired.end() - 1);
-            auto maxGreen = std::max_element(igreen.begin() + 1, igreen.end() - 1);
-            auto maxBlue = std::max_element(iblue.begin() + 1, iblue.end() - 1);
-            auto maxAll = static_cast<F32>(std::max(*maxRed, std::max(*maxGreen, *maxBlue)));
-            for (memory::Size i = 0; i < NUM_BUCKETS; i++) {
-                red[i] = static_cast<F32>(ired[i]) / maxAll;
-                green[i] = static_cast<F32>(igreen[i]) / maxAll;
-                blue[i] = static_cast<F32>(iblue[i]) / maxAll;
+            U32 maxCount = 1;
+            for (memory::Size channel = 0; channel < 3; ++channel) {
+                auto first = bins.begin() + channel * N;
+                maxCount = std::max(maxCount, *std::max_element(first + 1, first + N - 1));
+            }
+            auto maxAll = static_cast<F32>(maxCount);
+            for (memory::Size i = 0; i < N; i++) {
+                red[i] = static_cast<F32>(bins[i]) / maxAll;
+                green[i] = static_cast<F32>(bins[N + i]) / maxAll;
+                blue[i] = static_cast<F32>(bins[2 * N + i]) / maxAll;
             }
         }
 
         void generateTest() noexcept {
-            #pragma omp parallel for
             for (memory::Size i = 0; i < NUM_BUCKETS; i++) {
                 float x =  static_cast<F32>(i) / static_cast<F32>(NUM_BUCKETS);
                 float r = pow(0.5, pow(5 * (x - 0.5), 2));
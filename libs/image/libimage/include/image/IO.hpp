@@ -5,6 +5,11 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cassert>
+#include <functional>
+
+#include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imageio.h>
 
 #include <image/CoreTypes.hpp>
@@ -20,38 +25,215 @@ namespace image {
         String reason;
     };
 
-    template <class T>
-    Expected<ImageBuf<T>, ImageIOError> readImageBufFromFile(const Path &path, const ImageReadOptions &opts = ImageReadOptions()) {
+    /**
+     * @brief Decodes an image a band of rows at a time into a buffer provided by the caller.
+     *
+     * A band is a strip of scanlines, or a row of tiles for tiled files. Each band is reported as soon as it has been
+     * decoded, so work on it (e.g. uploading it to a device) can start before the rest of the image is decoded.
+     *
+     * Images are always read as RGB: extra channels are dropped and single channel images are replicated to grey.
+     */
+    class ImageReader {
+    public:
+        /// Called with the first row and number of rows of each band, in order.
+        using BandCallback = std::function<void(memory::Size firstRow, memory::Size numRows)>;
+
+        /// Rows decoded at a time from scanline files.
+        constexpr static const memory::Size SCANLINE_BAND_HEIGHT { 64 };
+
+        static Expected<ImageReader, ImageIOError> open(const Path &path,
+                                                       const ImageReadOptions &opts = ImageReadOptions()) {
+            ImageReader reader;
+            reader.path = path;
+            reader.isCancelled = opts.isCancelled;
+            if (opts.halfSize) {
+                reader.spec.attribute("raw:half_size", 1);
+            }
+            reader.input = OIIO::ImageInput::create(path.string());
+            if (!reader.input) {
+                return Unexpected(ImageIOError(path, OIIO::geterror()));
+            }
+            if (!reader.input->open(path, reader.spec, reader.spec)) {
+                return Unexpected(ImageIOError(path, OIIO::geterror()));
+            }
+            if (opts.halfSize) {
+                if (String(reader.input->format_name()) == "raw") {
+                    reader.isReduced_ = true;
+                } else if (auto levelSpec = reader.input->spec(0, 1); levelSpec.width > 0) {
+                    // Formats with MIP levels (tiled TIFF, EXR) have a half size image ready to read.
+                    reader.spec = levelSpec;
+                    reader.mipLevel = 1;
+                    reader.isReduced_ = true;
+                }
+            }
+            return reader;
+        }
+
+        ImageSize size() const noexcept {
+            return ImageSize { static_cast<memory::Size>(spec.width), static_cast<memory::Size>(spec.height) };
+        }
+
+        /**
+         * @brief Whether the image is read at less than its full resolution.
+         */
+        bool isReduced() const noexcept { return isReduced_; }
+
+        /**
+         * @brief Decode the whole image into imageBuf, which must already be size(). An RGBX imageBuf's padding
+         * channel is left as it was.
+         */
+        template <class T, ChannelsSpec Channels>
+        Expected<void, ImageIOError> read(ImageBuf<T, Channels> &imageBuf, const BandCallback &onBand = nullptr) {
+            static_assert(Channels::numChannels() >= 3);
+            assert(imageBuf.size == size());
+            auto format = OIIO::TypeDescFromC<T>::value();
+            auto width = static_cast<memory::Size>(spec.width);
+            auto height = static_cast<memory::Size>(spec.height);
+            // The buffer's layout is the same whatever the file has, so strides must always be given explicitly.
+            OIIO::stride_t xStride = Channels::numChannels() * sizeof(T);
+            OIIO::stride_t yStride = imageBuf.rowPitchBytes();
+            int numChannels = spec.nchannels >= 3 ? 3 : 1;
+            bool isTiled = spec.tile_width > 0;
+            memory::Size bandHeight = isTiled ? static_cast<memory::Size>(spec.tile_height) : SCANLINE_BAND_HEIGHT;
+
+            for (memory::Size row = 0; row < height; row += bandHeight) {
+                if (isCancelled && isCancelled->load(std::memory_order_relaxed)) {
+                    return Unexpected(ImageIOError(path, "Cancelled"));
+                }
+                memory::Size numRows = std::min(bandHeight, height - row);
+                T *bandData = imageBuf.row(row);
+                int yBegin = spec.y + static_cast<int>(row);
+                int yEnd = yBegin + static_cast<int>(numRows);
+                bool ok = isTiled ? input->read_tiles(0, mipLevel, spec.x, spec.x + spec.width, yBegin, yEnd, spec.z,
+                                                      spec.z + 1, 0, numChannels, format, bandData, xStride, yStride,
+                                                      OIIO::AutoStride)
+                                  : input->read_scanlines(0, mipLevel, yBegin, yEnd, spec.z, 0, numChannels, format,
+                                                          bandData, xStride, yStride);
+                if (!ok) {
+                    return Unexpected(ImageIOError(path, input->geterror()));
+                }
+                if (numChannels == 1) {
+                    for (memory::Size y = row; y < row + numRows; ++y) {
+                        expandGrey(imageBuf.row(y), width, Channels::numChannels());
+                    }
+                }
+                if (onBand) {
+                    onBand(row, numRows);
+                }
+            }
+            return success;
+        }
+
+        /**
+         * @brief Read the preview embedded in a RAW file instead of decoding the image.
+         *
+         * Fails for files that aren't RAW or have no preview.
+         */
+        template <class T>
+        Expected<ImageBuf<T>, ImageIOError> readEmbeddedPreview() {
+            if (String(input->format_name()) != "raw") {
+                return Unexpected(ImageIOError(path, "Only RAW files have embedded previews"));
+            }
+            OIIO::ImageBuf thumbnail;
+            if (!input->get_thumbnail(thumbnail, 0) || !thumbnail.initialized()) {
+                return Unexpected(ImageIOError(path, input->geterror()));
+            }
+
+            const auto &thumbnailSpec = thumbnail.spec();
+            auto imageBuf = ImageBuf<T>(thumbnailSpec.width, thumbnailSpec.height);
+            int numChannels = thumbnailSpec.nchannels >= 3 ? 3 : 1;
+            auto roi = thumbnail.roi();
+            roi.chbegin = 0;
+            roi.chend = numChannels;
+            OIIO::stride_t xStride = 3 * sizeof(T);
+            OIIO::stride_t yStride = imageBuf.rowPitchBytes();
+            if (!thumbnail.get_pixels(roi, OIIO::TypeDescFromC<T>::value(), imageBuf.data(), xStride, yStride)) {
+                return Unexpected(ImageIOError(path, thumbnail.geterror()));
+            }
+            if (numChannels == 1) {
+                for (memory::Size y = 0; y < imageBuf.height(); ++y) {
+                    expandGrey(imageBuf.row(y), imageBuf.width(), 3);
+                }
+            }
+            return imageBuf;
+        }
+
+    private:
+        Path path;
         OIIO::ImageSpec spec;
-        if (opts.halfSize) {
-            spec.attribute("raw:half_size", 1);
+        OIIO::ImageInput::unique_ptr input;
+        int mipLevel { 0 };
+        bool isReduced_ { false };
+        const std::atomic<bool> *isCancelled { nullptr };
+
+        /**
+         * @brief Copy the first channel of each of n pixels, numChannels apart, to the second and third.
+         */
+        template <class T>
+        static void expandGrey(T *data, memory::Size n, memory::Size numChannels) noexcept {
+            for (memory::Size i = 0; i < n; ++i) {
+                data[numChannels * i + 1] = data[numChannels * i];
+                data[numChannels * i + 2] = data[numChannels * i];
+            }
         }
-        auto iin = OIIO::ImageInput::create(path.string());
-        if (!iin) {
-            return Unexpected(ImageIOError(path, OIIO::geterror()));
+    };
+
+    template <class T>
+    Expected<ImageBuf<T>, ImageIOError> readImageBufFromFile(const Path &path, const ImageReadOptions &opts = ImageReadOptions()) {
+        auto reader = ImageReader::open(path, opts);
+        if (reader.hasError()) {
+            return Unexpected(reader.error());
         }
-        if (!iin->open(path, spec, spec)) {
-            return Unexpected(ImageIOError(path, OIIO::geterror()));
+        auto imageBuf = ImageBuf<T>(reader->size());
+        auto readResult = reader->read(imageBuf);
+        if (readResult.hasError()) {
+            return Unexpected(readResult.error());
         }
-        auto imageBuf = ImageBuf<T>(spec.width, spec.height);
-        // Assumes a packed, interleaved, RGB layout.
-        iin->read_image(
-            0, 0, 0, 4, // Sub-image 0, Mip-level 0, channels [0, 4) (RGB)
-            OIIO::TypeDescFromC<T>::value(), imageBuf.data(),
-            OIIO::AutoStride, OIIO::AutoStride, OIIO::AutoStride,
-            nullptr, nullptr
-        );
         return imageBuf;
     }
 
+    /**
+     * @brief An image's embedded preview, and the size the image itself will be once it's read.
+     */
     template <class T>
-    Expected<void, ImageIOError> writeImageBufToFile(const Path &path, const ImageBuf<T> &imageBuf) {
+    struct EmbeddedPreview {
+        ImageBuf<T> image;
+        ImageSize imageSize;
+    };
+
+    /**
+     * @brief Read the preview embedded in a RAW file, which takes milliseconds rather than a full decode.
+     *
+     * Fails for files that aren't RAW or have no preview. opts should match those the image itself is read with.
+     */
+    template <class T>
+    Expected<EmbeddedPreview<T>, ImageIOError> readEmbeddedPreviewFromFile(
+        const Path &path, const ImageReadOptions &opts = ImageReadOptions()) {
+        auto reader = ImageReader::open(path, opts);
+        if (reader.hasError()) {
+            return Unexpected(reader.error());
+        }
+        auto preview = reader->template readEmbeddedPreview<T>();
+        if (preview.hasError()) {
+            return Unexpected(preview.error());
+        }
+        return EmbeddedPreview<T> { std::move(*preview), reader->size() };
+    }
+
+    /**
+     * @brief Write the RGB channels of imageBuf to an image file. An RGBX imageBuf's padding channel is left out.
+     */
+    template <class T, ChannelsSpec Channels>
+    Expected<void, ImageIOError> writeImageBufToFile(const Path &path, const ImageBuf<T, Channels> &imageBuf) {
+        static_assert(Channels::numChannels() >= 3);
         auto iout = OIIO::ImageOutput::create(path.string());
         OIIO::ImageSpec spec(imageBuf.width(), imageBuf.height(), 3, OIIO::TypeDescFromC<T>::value());
         if (!iout->open(path.string(), spec)) {
             return Unexpected(ImageIOError(path, OIIO::geterror()));
         }
-        if (!iout->write_image(OIIO::TypeDescFromC<T>::value(), imageBuf.data())) {
+        OIIO::stride_t xStride = Channels::numChannels() * sizeof(T);
+        OIIO::stride_t yStride = imageBuf.rowPitchBytes();
+        if (!iout->write_image(OIIO::TypeDescFromC<T>::value(), imageBuf.data(), xStride, yStride)) {
             return Unexpected(ImageIOError(path, OIIO::geterror()));
         }
         iout->close();
@@ -64,7 +246,8 @@ namespace image {
         if (!iout->open(path.string(), spec)) {
             return Unexpected(ImageIOError(path, OIIO::geterror()));
         }
-        if (!iout->write_image(OIIO::TypeDescFromC<F32>::value(), mask.data())) {
+        auto format = OIIO::TypeDescFromC<F32>::value();
+        if (!iout->write_image(format, mask.data(), OIIO::AutoStride, mask.rowPitchBytes())) {
             return Unexpected(ImageIOError(path, OIIO::geterror()));
         }
         iout->close();
@@ -8,6 +8,28 @@
 
 namespace image {
 
+    /**
+     * @brief Bytes each row of an aligned ImageBuf starts on a multiple of: a cache line, which is also the widest
+     * vector load.
+     */
+    constexpr memory::Size ROW_ALIGNMENT { 64 };
+
+    /**
+     * @brief How the rows of an ImageBuf are laid out in memory.
+     */
+    enum class RowLayout {
+        /// Each row follows straight on from the one before.
+        Packed,
+        /// Each row starts on a multiple of ROW_ALIGNMENT bytes, with padding after the one before as needed.
+        Aligned,
+    };
+
+    /**
+     * @brief Images with channels have their rows aligned. Masks stay packed, as they're handed to the device whole.
+     */
+    template <ChannelsSpec Channels>
+    constexpr RowLayout defaultRowLayout = Channels::numChannels() > 0 ? RowLayout::Aligned : RowLayout::Packed;
+
     template <ChannelsSpec Channels>
     constexpr Shape dimsForChannels(std::size_t width, std::size_t height) {
         if constexpr (Channels::numChannels() != 0) {
@@ -17,10 +39,25 @@ namespace image {
         }
     }
 
+    /**
+     * @brief Stride alignments, in elements of T, giving rows the layout.
+     */
+    template <class T, ChannelsSpec Channels>
+    constexpr Shape alignmentsForLayout(RowLayout layout) {
+        static_assert(ROW_ALIGNMENT % sizeof(T) == 0);
+        std::size_t rowAlignment = layout == RowLayout::Aligned ? ROW_ALIGNMENT / sizeof(T) : 1;
+        if constexpr (Channels::numChannels() != 0) {
+            return Shape { 1, 1, rowAlignment };
+        } else {
+            return Shape { 1, rowAlignment };
+        }
+    }
+
     /**
      * @brief Container for in-memory pixel data.
      *
-     * An interleaved pixel layout is assumed.
+     * An interleaved pixel layout is assumed. Rows may be padded (see RowLayout), so anything walking the pixels
+     * should go a row at a time, from row(), rather than assume one follows on from the last.
      *
      * @tparam T The color component type
      * @tparam Channels The channel specification for this image. Defaults to RGB
@@ -36,6 +73,18 @@ namespace image {
         std::size_t width() const noexcept { return size.x; }
         std::size_t height() const noexcept { return size.y; }
 
+        /**
+         * @brief Elements of T from the start of one row to the start of the next.
+         */
+        std::size_t rowPitch() const noexcept { return pixelArray.stride(Channels::numChannels() != 0 ? 2 : 1); }
+
+        std::size_t rowPitchBytes() const noexcept { return rowPitch() * sizeof(T); }
+
+        bool isPacked() const noexcept { return pixelArray.isContiguous(); }
+
+        T *row(std::size_t y) noexcept { return data() + y * rowPitch(); }
+        const T *row(std::size_t y) const noexcept { return data() + y * rowPitch(); }
+
         ColorRGB<T> *begin() noexcept { return pixelArray.begin(); }
         const ColorRGB<T> *begin() const noexcept { return pixelArray.begin(); }
 
@@ -59,10 +108,13 @@ namespace image {
         }
 
         ImageBuf() noexcept : pixelArray(dimsForChannels<Channels>(0, 0)) {}
-        ImageBuf(std::size_t width, std::size_t height) noexcept
-          : pixelArray(dimsForChannels<Channels>(width, height))
+        ImageBuf(std::size_t width, std::size_t height, RowLayout layout = defaultRowLayout<Channels>) noexcept
+          : pixelArray(dimsForChannels<Channels>(width, height),
+                       alignmentsForLayout<T, Channels>(layout),
+                       ROW_ALIGNMENT)
           , size(width, height) {}
-        ImageBuf(const ImageSize &s) noexcept : pixelArray(dimsForChannels<Channels>(s.x, s.y)), size(s) {}
+        ImageBuf(const ImageSize &s, RowLayout layout = defaultRowLayout<Channels>) noexcept
+          : ImageBuf(s.x, s.y, layout) {}
         explicit ImageBuf(const NDArray<ColorRGB<T>> &array) noexcept : pixelArray(array), size(array.shape().at(1), array.shape().at(2)) {}
         explicit ImageBuf(NDArray<ColorRGB<T>> &&array) noexcept : pixelArray(std::move(array)), size(pixelArray.shape().at(1), pixelArray.shape().at(2)) {}
     };
@@ -1,9 +1,14 @@
 #pragma once
 
+#include <atomic>
+
 namespace image {
 
     struct ImageReadOptions {
+        /// Read at half resolution where the format makes that cheap: RAW files and files with MIP levels.
         bool halfSize { true };
+        /// If given, reading stops at the next band once this is set, failing with a "Cancelled" error.
+        const std::atomic<bool> *isCancelled { nullptr };
     };
 
 }
@@ -110,6 +110,8 @@ namespace image {
 
     using Greyscale = ChannelList<>;
     using RGB = ChannelList<Channel::Red, Channel::Green, Channel::Blue>;
+    /// RGB padded to four channels, so that each pixel is one aligned vector.
+    using RGBX = ChannelList<Channel::Red, Channel::Green, Channel::Blue, Channel::X>;
     using RGBA = ChannelList<Channel::Red, Channel::Green, Channel::Blue, Channel::Alpha>;
     using ARGB = ChannelList<Channel::Alpha, Channel::Red, Channel::Green, Channel::Blue>;
 
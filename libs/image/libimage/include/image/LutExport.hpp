@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+
+#include <image/Composition.hpp>
+#include <image/CoreTypes.hpp>
+#include <image/Expected.hpp>
+#include <image/luts/Lattice3D.hpp>
+
+namespace image {
+
+    struct LutExportError {
+        Path path;
+        String reason;
+    };
+
+    /// Lattice sizes LUTs are commonly exchanged at.
+    constexpr std::array<std::size_t, 4> LUT_EXPORT_SIZES { 17, 33, 65, 129 };
+
+    /**
+     * @brief Accumulate the composition's enabled, unmasked layers into one lattice with size nodes per side.
+     *
+     * Masked layers only apply to part of the image, so they can't be part of a LUT and are skipped.
+     */
+    luts::Lattice3D bakeComposition(const Composition &composition, std::size_t size) noexcept;
+
+    /**
+     * @brief Bake the composition and write it to path: as a .cube file, or a Hald image for any other extension.
+     *
+     * Hald images hold a square number of nodes per side, so they're baked at the smallest one of at least size.
+     */
+    Expected<void, LutExportError> exportLut(const Composition &composition,
+                                             const Path &path,
+                                             std::size_t size) noexcept;
+
+    /**
+     * @brief Bakes and writes a LUT on a thread of its own, as exportLut() does, so that editing carries on meanwhile.
+     */
+    class LutExportJob {
+    public:
+        using Result = Expected<void, LutExportError>;
+        /// Called on the job's thread once it's done.
+        using FinishedCallback = std::function<void(const Result &)>;
+
+        /**
+         * @brief Start exporting.
+         *
+         * The composition is copied before this returns, so call it from the thread that edits the composition.
+         */
+        LutExportJob(const Composition &composition,
+                     const Path &path,
+                     std::size_t size,
+                     FinishedCallback onFinished = nullptr) noexcept;
+        ~LutExportJob() noexcept;
+
+        LutExportJob(const LutExportJob &) = delete;
+        LutExportJob &operator=(const LutExportJob &) = delete;
+
+        bool isFinished() const noexcept { return isFinished_; }
+
+    private:
+        std::shared_ptr<Composition> composition;
+        Path path;
+        std::size_t size;
+        FinishedCallback onFinished;
+        std::atomic<bool> isFinished_ { false };
+        std::thread thread;
+    };
+
+}
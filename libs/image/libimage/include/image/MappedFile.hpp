@@ -0,0 +1,39 @@
+#pragma once
+
+#include <image/CoreTypes.hpp>
+#include <image/Expected.hpp>
+
+namespace image {
+
+    struct MappedFileError {
+        Path path;
+        String reason;
+    };
+
+    /**
+     * @brief Read-only memory mapping of a whole file. Unmapped on destruction.
+     */
+    class MappedFile {
+    public:
+        static Expected<MappedFile, MappedFileError> open(const Path &path) noexcept;
+
+        StringView view() const noexcept { return StringView { data_, size_ }; }
+        const char *data() const noexcept { return data_; }
+        std::size_t size() const noexcept { return size_; }
+
+        MappedFile(MappedFile &&other) noexcept;
+        MappedFile &operator=(MappedFile &&other) noexcept;
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+        ~MappedFile() noexcept;
+
+    private:
+        const char *data_ { nullptr };
+        std::size_t size_ { 0 };
+
+        MappedFile() noexcept {}
+
+        void unmap() noexcept;
+    };
+
+}
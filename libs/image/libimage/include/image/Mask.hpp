@@ -1,5 +1,8 @@
 #pragma once
 
+#include <optional>
+#include <vector>
+
 #include <glm/glm.hpp>
 
 #include <image/CoreTypes.hpp>
@@ -10,20 +13,138 @@ namespace image {
 
     using Mask = ImageBuf<F32, Greyscale>;
 
+    /**
+     * @brief Masks are generated in a perceptual space. This converts them to linear coverage for blending.
+     */
+    constexpr F32 maskGamma = 2.2f;
+
+    /**
+     * @brief Storage formats for masks uploaded for processing.
+     */
+    enum class MaskFormat {
+        F32,
+        F16,
+        U8,
+    };
+
+    struct TiledMask;
+
     struct MaskGeneratorMeta {
         String id;
         String name;
     };
 
+    /**
+     * @brief Identifies the formula a processing kernel should use to evaluate a ProceduralMask.
+     *
+     * Values must match the PROCEDURAL_MASK_* constants in kernels.cl.
+     */
+    enum class ProceduralMaskKind : I32 {
+        LinearGradient = 1,
+    };
+
+    /**
+     * @brief Parameters for a mask which can be evaluated per-pixel without a mask buffer.
+     *
+     * Positions are normalised to [0, 1] over the image. The meaning of params depends on the kind.
+     */
+    struct ProceduralMask {
+        ProceduralMaskKind kind;
+        glm::vec4 params;
+    };
+
+    /**
+     * @brief A rectangular region of a mask, in pixels.
+     */
+    struct MaskRegion {
+        memory::Size x { 0 };
+        memory::Size y { 0 };
+        memory::Size width { 0 };
+        memory::Size height { 0 };
+    };
+
+    /**
+     * @brief Size of a mask for an image, rounding up so that every image pixel is covered.
+     */
+    constexpr ImageSize reducedMaskSize(const ImageSize &size, memory::Size divisor) noexcept {
+        return ImageSize { (size.x + divisor - 1) / divisor, (size.y + divisor - 1) / divisor };
+    }
+
+    /**
+     * @brief Find the regions of a mask which differ between two sets of procedural mask parameters.
+     *
+     * Regions are conservative: every differing pixel is covered, though some covered pixels may be unchanged.
+     */
+    std::vector<MaskRegion> changedRegions(const ProceduralMask &prev,
+                                           const ProceduralMask &next,
+                                           const ImageSize &size) noexcept;
+
+    /**
+     * @brief Edge-aware refinement applied to a generated mask, using the image as a guide.
+     *
+     * Radius is a fraction of the image width; zero disables refinement. Epsilon controls how strong an edge has to
+     * be to be preserved, smaller values preserve weaker edges.
+     */
+    struct MaskRefinement {
+        F32 radius { 0.0f };
+        F32 epsilon { 1e-3f };
+    };
+
     struct AbstractMaskGenerator {
         bool isEnabled { true };
-        
+        MaskRefinement refinement;
+
+        /**
+         * @brief Whether generated masks are refined. Refined masks always need a dense mask buffer.
+         */
+        bool isRefined() const noexcept { return refinement.radius > 0.0f; }
+
         virtual const MaskGeneratorMeta &getMeta() const noexcept = 0;
         virtual void generate(const ImageBuf<F32> &img, Mask &mask) const noexcept = 0;
 
+        /**
+         * @brief Generate only the pixels of mask within region.
+         *
+         * Generators which can't work on a sub-region regenerate the whole mask.
+         */
+        virtual void generateRegion(const ImageBuf<F32> &img, Mask &mask, const MaskRegion &) const noexcept {
+            generate(img, mask);
+        }
+
+        /**
+         * @brief How many times smaller than the image this generator's masks are in each dimension.
+         *
+         * Smooth masks can be generated at a reduced resolution and are upsampled by the processing kernel.
+         */
+        virtual memory::Size resolutionDivisor() const noexcept { return 1; }
+
+        /**
+         * @brief Get the parameters for evaluating this mask inline, if it is analytic.
+         *
+         * Generators returning a value here never need a mask buffer for processing.
+         */
+        virtual std::optional<ProceduralMask> procedural() const noexcept { return std::nullopt; }
+
+        /**
+         * @brief Whether this generator's masks are mostly empty and should be processed as a TiledMask.
+         */
+        virtual bool isSparse() const noexcept { return false; }
+
+        /**
+         * @brief Bring a tiled mask up to date. Only used when isSparse() is true.
+         */
+        virtual void generateTiled(TiledMask &) const noexcept {}
+
         virtual ~AbstractMaskGenerator() noexcept {}
     };
 
+    /**
+     * @brief Fill mask with the luma of img, sampled at the centre of the divisor-sided block each mask pixel covers.
+     *
+     * divisor must be the mask generator's resolutionDivisor(), which is what upsampling the mask assumes.
+     */
+    void downsampleLuma(const ImageBuf<F32> &img, Mask &mask, memory::Size divisor) noexcept;
+
     struct LumaMaskGenerator : public AbstractMaskGenerator {
         static inline MaskGeneratorMeta meta { "maskGenerators.luma", "Luma Mask" };
 
@@ -31,6 +152,8 @@ namespace image {
 
         virtual void generate(const ImageBuf<F32> &img, Mask &mask) const noexcept override;
 
+        virtual memory::Size resolutionDivisor() const noexcept override { return 4; }
+
         virtual ~LumaMaskGenerator() noexcept {}
     };
 
@@ -60,10 +183,58 @@ namespace image {
 
         virtual void generate(Mask &mask) const noexcept override;
 
+        virtual void
+        generateRegion(const ImageBuf<F32> &, Mask &mask, const MaskRegion &region) const noexcept override;
+
+        /**
+         * @brief Params are (a, b, c1, c2): the projection onto the gradient direction and its start and end values.
+         */
+        virtual std::optional<ProceduralMask> procedural() const noexcept override;
+
         constexpr LinearGradientMaskSpec() noexcept {}
         constexpr LinearGradientMaskSpec(const glm::vec2 &from, const glm::vec2 &to) noexcept : from(from), to(to) {}
 
         virtual ~LinearGradientMaskSpec() noexcept {}
     };
 
+    /**
+     * @brief A single brush stroke.
+     *
+     * Points are normalised to [0, 1] over the image, while radius is a fraction of the image width. Hardness is the
+     * fraction of the radius painted at full strength.
+     */
+    struct BrushStroke {
+        F32 radius { 0.05f };
+        F32 hardness { 0.5f };
+        bool erase { false };
+        std::vector<glm::vec2> points;
+    };
+
+    /**
+     * @brief A mask painted with brush strokes.
+     *
+     * Strokes are applied in order. Appending strokes, or points to the last stroke, is cheap; any other edit should
+     * go through clearStrokes() so that cached rasterisations are rebuilt.
+     */
+    struct BrushMaskGenerator : public AbstractMaskGenerator {
+        std::vector<BrushStroke> strokes;
+        U64 epoch { 0 };
+
+        static inline MaskGeneratorMeta meta { "maskGenerators.brush", "Brush Mask" };
+
+        virtual const MaskGeneratorMeta &getMeta() const noexcept override { return meta; }
+
+        virtual void generate(const ImageBuf<F32> &img, Mask &mask) const noexcept override;
+
+        virtual bool isSparse() const noexcept override { return true; }
+        virtual void generateTiled(TiledMask &tiles) const noexcept override;
+
+        void clearStrokes() noexcept {
+            strokes.clear();
+            ++epoch;
+        }
+
+        virtual ~BrushMaskGenerator() noexcept {}
+    };
+
 }
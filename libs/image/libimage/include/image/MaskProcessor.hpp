@@ -17,6 +17,8 @@ namespace image {
     private:
         opencl::Program oclProgram;
         opencl::Kernel oclKernelGenerateOverlayImage;
+        /// Device copy of the mask being displayed. Processing uses PackedMask, so host masks have no device buffer.
+        Mask deviceMask;
     };
 
 }
@@ -76,6 +76,27 @@ namespace image {
             std::exclusive_scan(shape.begin(), shape.end(), strides.begin(), 1, std::multiplies<Shape::size_type>());
             return strides;
         }
+
+        // As shapeStride(), but with each stride rounded up to a multiple of that dimension's alignment, so that
+        // rows, say, can be padded to start on a cache line.
+        inline Shape shapeStride(const Shape &shape, const Shape &alignments) noexcept {
+            assert(alignments.dims().size() == shape.dims().size());
+            Shape strides = shape;
+            Shape::size_type stride = 1;
+            for (Shape::size_type i = 0; i < shape.dims().size(); ++i) {
+                stride = roundUpToMultiple(stride, alignments[i]);
+                strides[i] = stride;
+                stride *= shape[i];
+            }
+            return strides;
+        }
+
+        // Calculates how many elements an array's storage spans, including any padding between them.
+        inline Shape::size_type shapeSpan(const Shape &shape, const Shape &strides) noexcept {
+            auto numDims = shape.dims().size();
+            if (numDims == 0 || shape.size() == 0) { return shape.size(); }
+            return strides[numDims - 1] * shape[numDims - 1];
+        }
     }
 
     inline std::ostream &operator<<(std::ostream &output, const Shape &shape) noexcept {
@@ -139,7 +160,22 @@ namespace image {
         Shape shape() const noexcept { return shape_; }
         Shape strides() const noexcept { return strides_; }
 
-        size_type sizeBytes() const noexcept { return size() * type_->size(); }
+        /**
+         * @brief Elements between one index of a dimension and the next.
+         */
+        size_type stride(size_type dim) const noexcept { return strides_[dim]; }
+
+        /**
+         * @brief Elements the array's storage spans, which is more than size() if its dimensions are padded.
+         */
+        size_type spanSize() const noexcept { return detail::shapeSpan(shape_, strides_); }
+
+        /**
+         * @brief Whether the elements follow each other with no padding between them.
+         */
+        bool isContiguous() const noexcept { return spanSize() == size(); }
+
+        size_type sizeBytes() const noexcept { return spanSize() * type_->size(); }
 
         /**
          * @brief Calculates a byte offset into the array for the element identified by the shape index.
@@ -171,6 +207,21 @@ namespace image {
           , strides_(detail::shapeStride(shape_))
           , type_(type) {}
 
+        /**
+         * @brief Pad the stride of each dimension to a multiple of the given number of elements.
+         */
+        NDArrayBase(TypeRef type,
+                    Shape shape,
+                    Shape alignments,
+                    size_type alignment = 0,
+                    memory::AbstractAllocator *alloc = nullptr) noexcept
+          : NDArrayStorage(type->size() * detail::shapeSpan(shape, detail::shapeStride(shape, alignments)),
+                           alignment ? alignment : type->alignment(),
+                           alloc)
+          , shape_(shape)
+          , strides_(detail::shapeStride(shape_, alignments))
+          , type_(type) {}
+
     protected:
         NDArrayBase(TypeRef type, Shape shape, memory::SharedBuffer buffer) noexcept
           : NDArrayStorage(buffer)
@@ -204,29 +255,30 @@ namespace image {
         using pointer = T *;
         using const_pointer = const T *;
 
+        // Iterators run over the whole of the storage, padding included.
         iterator begin() noexcept { return (iterator)getPtr<T>(); }
         const_iterator begin() const noexcept { return (const_iterator)getPtr<T>(); }
-        iterator end() noexcept { return begin() + size(); }
-        const_iterator end() const noexcept { return begin() + size(); }
+        iterator end() noexcept { return begin() + spanSize(); }
+        const_iterator end() const noexcept { return begin() + spanSize(); }
 
         pointer data() noexcept { return pointer(begin()); }
         const_pointer data() const noexcept { return const_pointer(begin()); }
 
         reference operator[](size_type idx) noexcept {
-            assert(idx < size());
+            assert(idx < spanSize());
             return begin()[idx];
         }
         const_reference operator[](size_type idx) const noexcept {
-            assert(idx < size());
+            assert(idx < spanSize());
             return begin()[idx];
         }
 
         reference at(size_type idx) noexcept {
-            assert(idx < size());
+            assert(idx < spanSize());
             return begin()[idx];
         }
         const_reference at(size_type idx) const noexcept {
-            assert(idx < size());
+            assert(idx < spanSize());
             return begin()[idx];
         }
 
@@ -256,7 +308,7 @@ namespace image {
         }
 
         NDArray reshape(Shape s) noexcept {
-            assert(s.size() == size());
+            assert(isContiguous() && s.size() == size());
             return NDArray(s, NDArrayStorage::buffer);
         }
 
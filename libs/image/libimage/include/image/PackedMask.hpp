@@ -0,0 +1,57 @@
+#pragma once
+
+#include <memory>
+
+#include <image/CoreTypes.hpp>
+#include <image/ImageSpec.hpp>
+#include <image/Mask.hpp>
+#include <image/NDArray.hpp>
+#include <image/memory/Buffer.hpp>
+
+namespace image {
+
+    /**
+     * @brief Device-ready copy of a Mask in a compact storage format.
+     *
+     * Values are linearised (raised to maskGamma) when packed so that kernels can blend with them directly.
+     */
+    struct PackedMask {
+        MaskFormat format { MaskFormat::F16 };
+        ImageSize size;
+        NDArray<U8> data;
+
+        static constexpr memory::Size bytesPerPixel(MaskFormat format) noexcept {
+            switch (format) {
+            case MaskFormat::F32:
+                return sizeof(F32);
+            case MaskFormat::F16:
+                return sizeof(U16);
+            case MaskFormat::U8:
+                return sizeof(U8);
+            }
+            return 0;
+        }
+
+        /**
+         * @brief Pack and upload the whole mask.
+         */
+        void pack(const Mask &mask) noexcept;
+
+        /**
+         * @brief Pack and upload only the given region of the mask.
+         */
+        void pack(const Mask &mask, const MaskRegion &region) noexcept;
+
+        /**
+         * @brief Make a device which stores a packed mask as a single channel 2D image, so kernels can filter it.
+         */
+        static std::shared_ptr<memory::AbstractDevice> makeImageDevice(MaskFormat format,
+                                                                       const ImageSize &size) noexcept;
+
+        PackedMask() noexcept {}
+        PackedMask(MaskFormat format,
+                   const ImageSize &size,
+                   std::shared_ptr<memory::AbstractDevice> device) noexcept;
+    };
+
+}
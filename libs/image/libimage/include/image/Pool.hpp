@@ -44,6 +44,8 @@ namespace image {
     public:
         T *operator->() { return ptr; }
         T &operator*() { return *ptr; }
+        const T *operator->() const { return ptr; }
+        const T &operator*() const { return *ptr; }
 
         PoolLease(T *ptr, detail::PoolControl *ctrl) noexcept : ptr(ptr), ctrl(ctrl) { ctrl->retain(); }
 
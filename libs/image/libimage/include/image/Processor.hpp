@@ -1,39 +1,93 @@
 #pragma once
 
 #include <memory>
+#include <optional>
+#include <set>
 #include <vector>
 
 #include <image/Composition.hpp>
 #include <image/CoreTypes.hpp>
+#include <image/GuidedFilter.hpp>
+#include <image/Histogram.hpp>
 #include <image/ImageBuf.hpp>
 #include <image/NDArray.hpp>
+#include <image/PackedMask.hpp>
 #include <image/Pool.hpp>
+#include <image/TiledMask.hpp>
+#include <image/luts/Lattice1D.hpp>
 #include <image/luts/Lattice3D.hpp>
+#include <image/luts/TetrahedralInterpolator.hpp>
 #include <image/opencl/Program.hpp>
 
 namespace image {
 
     /**
-     * @brief Helper class wrapping a 3D LUT.
+     * @brief How LUTs are stored on the device, which decides how the kernels look them up.
+     */
+    enum class LutStorage {
+        /// A 3D image, sampled with linear filtering.
+        Image,
+        /// A plain buffer, interpolated tetrahedrally by the kernels.
+        Buffer,
+    };
+
+    /**
+     * @brief Buffers for CPU devices, which emulate image sampling slowly. Images otherwise.
+     *
+     * This isn't a way to run on devices without image support: reduced resolution masks and the guided filter are
+     * sampled as images whatever the LUT storage.
+     */
+    LutStorage defaultLutStorage() noexcept;
+
+    /**
+     * @brief Whether Processor::process() should run on the host with TiledExecutor: true for CPU devices.
+     */
+    bool defaultTiledOnHost() noexcept;
+
+    /**
+     * @brief Helper class wrapping a 3D LUT, and the curves used instead when everything in it is separable.
      *
-     * This is currently required to use the lattice with an OpenCL sampler.
+     * This is currently required to get the lattice or curves onto the device in a form the kernels can look up.
      */
     struct Lut {
-        luts::Lattice3D lattice { 32 };
+        luts::Lattice3D lattice { luts::Lattice3D::PROCESSING_SIZE };
+        /// Shape: {4, size, size, size}. RGBA nodes, on the device as either an image or a buffer.
         NDArray<F32> latticeImage;
+        /// The lattice as synced, for TiledExecutor.
+        luts::TetrahedralInterpolator interpolator;
+        luts::Lattice1D curves { luts::Lattice1D::PROCESSING_SIZE };
+        /// Shape: {size, 3}. The red curve, then green, then blue, in a device buffer.
+        NDArray<F32> curvesBuffer;
 
+        /**
+         * @brief Upload the lattice, and load it into the interpolator.
+         */
         void sync() noexcept;
+        /**
+         * @brief Upload the curves.
+         */
+        void syncCurves() noexcept;
         void reset() noexcept;
 
-        Lut() noexcept;
+        explicit Lut(LutStorage storage = LutStorage::Image) noexcept;
     };
 
     template <>
     struct PoolTraits<Lut> {
-        static inline Lut construct() noexcept { return Lut {}; }
+        static inline Lut construct(LutStorage storage) noexcept { return Lut { storage }; }
         static inline void recycle(Lut &lut) noexcept { lut.reset(); }
     };
 
+    /**
+     * @brief How an op's LUT is applied.
+     */
+    enum class OpKind {
+        /// A lookup in each channel's curve. Used while every filter in the op is separable.
+        Curves,
+        /// A 3D lookup in the lattice.
+        Lattice,
+    };
+
     /**
      * @brief Represents the application of a LUT to an image with an optional mask.
      *
@@ -42,6 +96,7 @@ namespace image {
     struct Op {
         PoolLease<Lut> lut;
         std::shared_ptr<AbstractMaskGenerator> maskGen;
+        OpKind kind { OpKind::Curves };
 
         explicit Op(PoolLease<Lut> &&lut) : lut(std::move(lut)) {}
     };
@@ -56,7 +111,9 @@ namespace image {
     /**
      * @brief Builds a sequence of operations to apply to an image from a number of Layers.
      *
-     * The generated OpSequence is only valid for the lifetime of the builder that made it.
+     * Filters are accumulated into an op's curves for as long as they're all separable. The first filter that isn't
+     * carries on from the curves in the op's lattice. The generated OpSequence is only valid for the lifetime of the
+     * builder that made it.
      */
     struct OpSequenceBuilder {
         AbstractPool<Lut> &lutPool;
@@ -83,12 +140,58 @@ namespace image {
      */
     struct CompositionState {
         ImageBuf<F32> input;
+        /// Host masks as generated. These are what gets displayed.
         std::map<AbstractMaskGenerator *, Mask> generatedMasks;
+        /// Device copies of generated masks used for processing. Kept in sync with generatedMasks.
+        std::map<AbstractMaskGenerator *, PackedMask> packedMasks;
+        /// Storage format for new packed masks.
+        MaskFormat maskFormat { MaskFormat::F16 };
+        std::set<AbstractMaskGenerator *> staleMasks;
+        /// Parameters procedural masks were last rasterised with. Used to only regenerate the changed regions.
+        std::map<AbstractMaskGenerator *, ProceduralMask> generatedParams;
+        std::map<AbstractMaskGenerator *, TiledMask> tiledMasks;
         std::unique_ptr<AbstractPool<ImageBuf<F32>>> intermediateImagePool;
+        /// Whether mask refinement runs with OpenCL rather than on the host.
+        bool refineOnDevice { true };
+        /// Created on first use.
+        std::unique_ptr<GuidedFilter> guidedFilter;
 
         void setInput(const ImageBuf<F32> &image) noexcept;
         Mask &update(AbstractMaskGenerator *maskGen) noexcept;
         Mask &mask(AbstractMaskGenerator *maskGen) noexcept;
+
+        /**
+         * @brief Mark the generated mask (if any) as out of date without regenerating it.
+         *
+         * The mask will be regenerated the next time it is requested.
+         */
+        void invalidate(AbstractMaskGenerator *maskGen) noexcept;
+
+        /**
+         * @brief Get the device copy of a generated mask, generating and packing it if necessary.
+         */
+        PackedMask &packedMask(AbstractMaskGenerator *maskGen) noexcept;
+
+        /**
+         * @brief Get the up to date, uploaded tiled mask for a sparse mask generator.
+         */
+        TiledMask &tiledMask(AbstractMaskGenerator *maskGen) noexcept;
+
+    private:
+        void refine(AbstractMaskGenerator *maskGen, Mask &maskBuf) noexcept;
+    };
+
+    /**
+     * @brief The kernels applying an op, one for each way its mask can be given.
+     */
+    struct ApplyLutKernels {
+        opencl::Kernel unmasked;
+        opencl::Kernel maskedF32;
+        opencl::Kernel maskedF16;
+        opencl::Kernel maskedU8;
+        opencl::Kernel maskedImage;
+        opencl::Kernel procedural;
+        opencl::Kernel tiled;
     };
 
     /**
@@ -102,11 +205,20 @@ namespace image {
         std::shared_ptr<Composition> composition;
 
         opencl::Program oclProgram;
-        opencl::Kernel oclKernelApplyLut;
-        opencl::Kernel oclKernelApplyLutMasked;
+        /// The same kernels, built to look up curves.
+        opencl::Program oclCurvesProgram;
+        ApplyLutKernels oclKernelsApplyLut;
+        ApplyLutKernels oclKernelsApplyCurves;
         opencl::Kernel oclKernelFinalize;
+        opencl::Kernel oclKernelFinalizeHistogram;
+        /// Work-items per group counting the histogram, limited by what the device can run the kernel with.
+        memory::Size histogramGroupSize { 1 };
+        opencl::Kernel oclKernelReduceHistogram;
         opencl::SamplerHandle oclSampler;
+        opencl::SamplerHandle oclMaskSampler;
 
+        /// Which build of the kernels is used. Fixed at construction.
+        LutStorage lutStorage;
         Pool<Lut, 10> lutPool;
 
         CompositionState state;
@@ -115,13 +227,43 @@ namespace image {
         OpSequence opSeq;
 
         bool areFiltersEnabled { true };
+        /// Whether process() applies the ops with TiledExecutor rather than kernels. Fixed at construction.
+        bool isTiledOnHost;
+
+        /// Whether process() also updates histogram. It's counted on the device while finalizing the output.
+        bool isHistogramEnabled { true };
+        Histogram<> histogram;
+        /// Shape: {3 * buckets, work-groups}. Per work-group counts, summed into histogramBins.
+        NDArray<U32> histogramPartialBins;
+        NDArray<U32> histogramBins;
 
         void init() noexcept;
         void setComposition(std::shared_ptr<Composition> comp) noexcept;
         void update() noexcept;
         void process(ImageBuf<U8> &out) noexcept;
 
-        explicit Processor() noexcept : opSeqBuilder(lutPool) {}
+        /**
+         * @brief Apply the composition to the input, leaving the result on the device.
+         *
+         * The result is either the input or an intermediate image held by lease, so it's valid while lease is.
+         */
+        ImageBuf<F32> &render(std::optional<PoolLease<ImageBuf<F32>>> &lease) noexcept;
+
+        explicit Processor(LutStorage lutStorage = defaultLutStorage(),
+                           bool isTiledOnHost = defaultTiledOnHost()) noexcept
+          : lutStorage(lutStorage)
+          , lutPool(lutStorage)
+          , opSeqBuilder(lutPool)
+          , isTiledOnHost(isTiledOnHost) {}
+
+    private:
+        void finalizeWithHistogram(ImageBuf<F32> &in, ImageBuf<U8> &outFinal) noexcept;
+
+        /**
+         * @brief Set a LUT kernel's arguments: the op's curves or lattice, however it's stored, followed by args.
+         */
+        template <class... Ts>
+        Expected<void, opencl::SetArgsError> setLutKernelArgs(opencl::Kernel &kernel, Op &op, Ts &&...args) noexcept;
     };
 
 }
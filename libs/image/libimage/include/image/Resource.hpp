@@ -1,11 +1,14 @@
 #pragma once
 
+#include <memory>
 #include <optional>
 
 #include <image/CoreTypes.hpp>
 #include <image/Expected.hpp>
 #include <image/ImageBuf.hpp>
-#include <image/luts/Lattice3D.hpp>
+#include <image/ImageIOOptions.hpp>
+#include <image/luts/LutCache.hpp>
+#include <image/memory/Buffer.hpp>
 
 namespace image {
 
@@ -16,13 +19,19 @@ namespace image {
     struct ImageResource {
         std::optional<Path> filePath;
         std::optional<ImageBuf<F32>> data;
+        /// Whether data is at less than the file's full resolution.
+        bool isReduced { false };
 
         inline void setPath(Path path) noexcept {
             unload();
             filePath = path;
         }
 
-        Expected<void, ResourceLoadError> load() noexcept;
+        /**
+         * @brief Load the image. If device is given, each band of the image is uploaded to it as soon as it's decoded.
+         */
+        Expected<void, ResourceLoadError> load(std::shared_ptr<memory::AbstractDevice> device = nullptr,
+                                               const ImageReadOptions &opts = ImageReadOptions()) noexcept;
         inline void unload() noexcept { data = std::nullopt; }
 
         explicit ImageResource() {}
@@ -31,7 +40,8 @@ namespace image {
 
     struct LutResource {
         std::optional<Path> filePath;
-        std::optional<luts::Lattice3D> data;
+        /// Shared with every other resource using the same file, through luts::LutCache.
+        std::shared_ptr<const luts::PreparedLut> data;
 
         inline void setPath(Path path) noexcept {
             unload();
@@ -39,7 +49,7 @@ namespace image {
         }
 
         Expected<void, ResourceLoadError> load() noexcept;
-        inline void unload() noexcept { data = std::nullopt; }
+        inline void unload() noexcept { data = nullptr; }
 
         explicit LutResource() {}
         explicit LutResource(Path filePath) : filePath(filePath) {}
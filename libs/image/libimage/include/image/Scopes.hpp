@@ -0,0 +1,47 @@
+#pragma once
+
+#include <image/CoreTypes.hpp>
+#include <image/ImageBuf.hpp>
+#include <image/NDArray.hpp>
+
+namespace image {
+
+    /**
+     * @brief Waveform scope: for each column of the image, how many pixels have each value, per channel.
+     *
+     * Densities are log scaled and normalised so that the densest bin is 1.
+     */
+    struct Waveform {
+        constexpr static const memory::Size NUM_COLUMNS { 256 };
+        constexpr static const memory::Size NUM_LEVELS { 256 };
+
+        /// Shape: {3, NUM_COLUMNS, NUM_LEVELS}.
+        NDArray<F32> density { Shape { 3, NUM_COLUMNS, NUM_LEVELS } };
+
+        /**
+         * @brief Bin roughly maxSamples pixels of img, however large it is.
+         */
+        void generate(const ImageBuf<U8> &img, memory::Size maxSamples) noexcept;
+
+    private:
+        NDArray<U32> counts { Shape { 3, NUM_COLUMNS, NUM_LEVELS } };
+    };
+
+    /**
+     * @brief Vectorscope: how many pixels have each chroma, using the Rec. 709 Cb and Cr of the encoded values.
+     *
+     * Densities are log scaled and normalised so that the densest bin is 1.
+     */
+    struct Vectorscope {
+        constexpr static const memory::Size SIZE { 256 };
+
+        /// Shape: {SIZE, SIZE}, indexed by Cb then Cr. Zero chroma is at the centre.
+        NDArray<F32> density { Shape { SIZE, SIZE } };
+
+        /**
+         * @brief Bin roughly maxSamples pixels of img, however large it is.
+         */
+        void generate(const ImageBuf<U8> &img, memory::Size maxSamples) noexcept;
+    };
+
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace image {
+
+    /**
+     * @brief Memory for the temporary buffers of tasks on one thread, kept from one task to the next.
+     *
+     * Allocations are bumped off blocks which are never freed, so once a thread has run a few tasks they cost nothing.
+     * Everything allocated while a Scope exists is released together when it ends. Nothing is constructed or
+     * destroyed, so it's only for trivially copyable types, which are written before they're read.
+     */
+    class ScratchArena {
+    public:
+        /// Allocations start on a cache line, so that threads never share one.
+        static constexpr std::size_t ALIGNMENT { 64 };
+
+        /**
+         * @brief Releases everything allocated from the arena since it was made.
+         */
+        class Scope {
+        public:
+            explicit Scope(ScratchArena &arena) noexcept
+              : arena(arena)
+              , block(arena.block)
+              , offset(arena.offset) {}
+            ~Scope() noexcept {
+                arena.block = block;
+                arena.offset = offset;
+            }
+
+            Scope(const Scope &) = delete;
+            Scope &operator=(const Scope &) = delete;
+
+        private:
+            ScratchArena &arena;
+            std::size_t block;
+            std::size_t offset;
+        };
+
+        /**
+         * @brief The calling thread's arena.
+         */
+        static ScratchArena &local() noexcept;
+
+        /**
+         * @brief Uninitialised space for count values of T, valid until the innermost Scope ends.
+         */
+        template <class T>
+        T *alloc(std::size_t count) noexcept {
+            static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>);
+            static_assert(alignof(T) <= ALIGNMENT);
+            return static_cast<T *>(allocBytes(count * sizeof(T)));
+        }
+
+    private:
+        struct Block {
+            std::unique_ptr<std::byte[]> data;
+            std::size_t size;
+        };
+
+        std::vector<Block> blocks;
+        /// The block being allocated from, and how far into it.
+        std::size_t block { 0 };
+        std::size_t offset { 0 };
+
+        void *allocBytes(std::size_t bytes) noexcept;
+    };
+
+}
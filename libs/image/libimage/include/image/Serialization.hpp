@@ -23,6 +23,12 @@ namespace image::serialization {
                  const image::FilterRegistry *filterRegistry,
                  const image::MaskGeneratorRegistry *maskGeneratorRegistry) noexcept;
 
+    /**
+     * @brief Copy a composition, with layers, filters and mask generators of its own, by writing and reading back
+     * each layer. The input image is shared.
+     */
+    image::Composition copyComposition(const image::Composition &comp) noexcept;
+
     String encodeFilters(const std::vector<image::AbstractFilterSpec *> &filters) noexcept;
     std::vector<std::unique_ptr<image::AbstractFilterSpec>> decodeFilters(const String &encoded) noexcept;
 
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <vector>
+
+#include <image/ThreadPool.hpp>
+
+namespace image {
+
+    /**
+     * @brief Tasks with dependencies between them, run on a ThreadPool.
+     *
+     * Each task is submitted as soon as the last of its dependencies finishes, by the thread that ran it, so a chain
+     * of tasks tends to stay on one thread. There are no barriers between stages: independent branches carry on
+     * regardless of how far the others have got.
+     */
+    class TaskGraph {
+    public:
+        using Node = std::size_t;
+
+        /**
+         * @brief Add a task to run once every one of dependencies has. They must already have been added.
+         */
+        Node add(std::function<void()> f, std::initializer_list<Node> dependencies = {}) noexcept;
+
+        /**
+         * @brief Run every task, and return once they've all finished. The graph can be run again afterwards.
+         */
+        void run(ThreadPool &pool = ThreadPool::shared()) noexcept;
+
+        std::size_t size() const noexcept { return tasks.size(); }
+
+    private:
+        struct Task {
+            std::function<void()> f;
+            std::vector<Node> successors;
+            std::size_t numDependencies { 0 };
+            /// Dependencies yet to finish in the current run.
+            std::atomic<std::size_t> pending { 0 };
+        };
+
+        /// A deque, as tasks can't be moved once added.
+        std::deque<Task> tasks;
+
+        void start(ThreadPool &pool, Node node, ThreadPool::Counter &remaining) noexcept;
+    };
+
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace image {
+
+    /**
+     * @brief A fixed set of worker threads, each taking tasks from its own deque.
+     *
+     * Workers run tasks from the back of their own deque, and steal from the front of the others' once it's empty, so
+     * uneven work evens out without every thread contending on one queue. Threads waiting on the pool help run the
+     * tasks they're waiting for, and sleep once none of those are left queued, so a parallel loop inside another just
+     * adds tasks to the same threads. Waiters never pick up unrelated tasks, which could hold them up for far longer
+     * than their own.
+     *
+     * All of libimage's CPU parallelism runs on shared(): see also TaskGraph and ScratchArena.
+     */
+    class ThreadPool {
+    public:
+        using Task = std::function<void()>;
+        /// Counts a waiter's unfinished tasks. Tasks submitted with it are the ones wait() on it helps with.
+        using Counter = std::atomic<std::size_t>;
+
+        /**
+         * @brief The pool shared by libimage, with a worker for every hardware thread but the caller's.
+         */
+        static ThreadPool &shared() noexcept;
+
+        explicit ThreadPool(std::size_t numWorkers) noexcept;
+        ~ThreadPool() noexcept;
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        std::size_t numWorkers() const noexcept { return workers.size(); }
+
+        /**
+         * @brief Threads running a parallelFor(): the workers and the caller.
+         */
+        std::size_t numThreads() const noexcept { return workers.size() + 1; }
+
+        /**
+         * @brief Queue task to run on a worker, or run it now if there are none.
+         *
+         * A worker queues it on its own deque, so follow-up tasks tend to stay on the thread whose data they use. If
+         * group is given, the task is one of the tasks it counts: it should finish by calling complete(*group).
+         */
+        void submit(Task task, const Counter *group = nullptr) noexcept;
+
+        /**
+         * @brief Count one of a group's tasks as finished, waking its waiter if it was the last.
+         *
+         * remaining mustn't be touched after this, as the waiter may return as soon as it reaches zero.
+         */
+        void complete(Counter &remaining) noexcept;
+
+        /**
+         * @brief Run the queued tasks of the group counted by remaining on the calling thread, and sleep while there
+         * are none, until remaining is zero.
+         */
+        void wait(const Counter &remaining) noexcept;
+
+        /**
+         * @brief Call f(begin, end) over [0, count) in ranges of grain indices, and return once they've all finished.
+         *
+         * The calling thread runs ranges too. Each worker is first given a contiguous share of the ranges, so
+         * neighbouring ranges tend to run on the same thread. A grain of 0 makes a few ranges for each thread, enough
+         * for stealing to even out uneven ranges.
+         */
+        void parallelForRanges(std::size_t count,
+                               const std::function<void(std::size_t, std::size_t)> &f,
+                               std::size_t grain = 0) noexcept;
+
+        /**
+         * @brief Call f(i) for every i in [0, count), as parallelForRanges().
+         */
+        template <class F>
+        void parallelFor(std::size_t count, F &&f, std::size_t grain = 0) noexcept {
+            parallelForRanges(
+                count,
+                [&f](std::size_t begin, std::size_t end) {
+                    for (std::size_t i = begin; i < end; ++i) { f(i); }
+                },
+                grain);
+        }
+
+    private:
+        struct Queued {
+            Task task;
+            const Counter *group;
+        };
+
+        struct Worker {
+            std::mutex mutex;
+            std::deque<Queued> tasks;
+            std::thread thread;
+        };
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        /// Tasks in any deque. Workers sleep while it's zero.
+        std::atomic<std::size_t> numQueued { 0 };
+        /// Where the next task submitted from outside the pool goes.
+        std::atomic<std::size_t> nextWorker { 0 };
+        std::mutex sleepMutex;
+        /// Wakes sleeping workers and waiters alike.
+        std::condition_variable wake;
+        /// Bumped whenever tasks are queued, so that waiters can tell whether there's anything new to look at.
+        std::size_t queueEpoch { 0 };
+        bool isStopping { false };
+
+        /**
+         * @brief Take a task from worker self's deque, or steal one. self is numWorkers() for other threads.
+         *
+         * Any task will do for a null group. Otherwise only the group's tasks are taken.
+         */
+        Task take(std::size_t self, const Counter *group = nullptr) noexcept;
+        /**
+         * @brief Wake the workers and waiters after queueing tasks.
+         */
+        void notify() noexcept;
+        void run(std::size_t self) noexcept;
+    };
+
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <image/CoreTypes.hpp>
+#include <image/Histogram.hpp>
+#include <image/ImageBuf.hpp>
+#include <image/Processor.hpp>
+#include <image/ThreadPool.hpp>
+
+namespace image {
+
+    /**
+     * @brief Applies an OpSequence on the host a tile at a time, finalizing each tile as soon as its ops are done.
+     *
+     * Each kernel run on a CPU device sweeps the whole frame, so the image streams through memory once per op. Here
+     * every op and the finalize step run on a tile small enough to stay in L2 before moving on to the next, so the
+     * input is only read and the output written once, however many ops there are. Tiles are spread over a ThreadPool.
+     */
+    struct TiledExecutor {
+        /// Pixels per tile. A tile's two working color buffers and mask factors take 112 KiB.
+        static constexpr memory::Size TILE_PIXELS { 4096 };
+
+        ThreadPool &pool;
+
+        /**
+         * @brief Apply seq to in, writing the finalized image to out's host memory, and count histogram if given.
+         *
+         * Masks are read from the same host copies the kernels' are uploaded from, generating them first if needed,
+         * so the output matches Processor::process().
+         */
+        void run(const OpSequence &seq,
+                 CompositionState &state,
+                 const ImageBuf<F32> &in,
+                 ImageBuf<U8> &out,
+                 Histogram<> *histogram) noexcept;
+
+        explicit TiledExecutor(ThreadPool &pool = ThreadPool::shared()) noexcept : pool(pool) {}
+    };
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <memory>
+#include <set>
+#include <vector>
+
+#include <image/CoreTypes.hpp>
+#include <image/ImageSpec.hpp>
+#include <image/Mask.hpp>
+#include <image/NDArray.hpp>
+
+namespace image {
+
+    /**
+     * @brief Sparse mask storage made of square tiles.
+     *
+     * Tiles which are entirely zero or entirely one aren't stored, they're only marked as such in the tile table. All
+     * other tiles occupy a slot in the tile pool. When a device is set, upload() only copies the slots modified since
+     * the last upload. Values are stored linearised (see maskGamma) so kernels can use them directly.
+     */
+    struct TiledMask {
+        static constexpr memory::Size tileSize = 64;
+        static constexpr I32 emptyTile = -1;
+        static constexpr I32 fullTile = -2;
+
+        ImageSize size;
+        memory::Size tilesX { 0 };
+        memory::Size tilesY { 0 };
+
+        /// Shape: {tilesX, tilesY}. Either emptyTile, fullTile or the index of a slot in the pool.
+        NDArray<I32> tileTable;
+        /// Shape: {tileSize, tileSize, capacity}.
+        NDArray<F32> tilePool;
+        memory::Size capacity { 0 };
+        memory::Size usedSlots { 0 };
+        std::vector<I32> freeSlots;
+
+        std::shared_ptr<memory::AbstractDevice> device;
+        std::set<I32> dirtySlots;
+        bool isTableDirty { true };
+        bool isPoolReallocated { true };
+
+        /// Book-keeping for generators which rasterise incrementally. The meaning is up to the generator.
+        U64 sourceEpoch { 0 };
+        memory::Size sourceCount { 0 };
+        memory::Size sourceSubCount { 0 };
+
+        I32 tile(memory::Size tx, memory::Size ty) const noexcept { return tileTable.at(tx, ty); }
+        F32 *slotData(I32 slot) noexcept { return &tilePool.at(0, 0, slot); }
+        const F32 *slotData(I32 slot) const noexcept { return &tilePool.at(0, 0, slot); }
+
+        F32 at(memory::Size x, memory::Size y) const noexcept;
+
+        /**
+         * @brief Get writable storage for a tile, giving it a slot first if it's currently empty or full.
+         */
+        F32 *editTile(memory::Size tx, memory::Size ty) noexcept;
+
+        /**
+         * @brief Mark a tile as wholly empty or full, releasing its slot if it has one.
+         */
+        void fillTile(memory::Size tx, memory::Size ty, I32 state) noexcept;
+
+        /**
+         * @brief Release the tile's slot if every pixel of it within the image has the same value of zero or one.
+         */
+        void compactTile(memory::Size tx, memory::Size ty) noexcept;
+
+        void clear() noexcept;
+        void setDevice(std::shared_ptr<memory::AbstractDevice> dev) noexcept;
+        void upload() noexcept;
+        void toDense(Mask &mask) const noexcept;
+
+        TiledMask() noexcept {}
+        explicit TiledMask(const ImageSize &size) noexcept;
+
+    private:
+        I32 allocateSlot() noexcept;
+        void growPool() noexcept;
+    };
+
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <optional>
+
+#include <image/CoreTypes.hpp>
+#include <image/Expected.hpp>
+#include <image/luts/CubeFile.hpp>
+
+namespace image::luts {
+
+    /**
+     * @brief Identifies the version of a source file that a binary cube was made from.
+     */
+    struct SourceStamp {
+        I64 modified { 0 };
+        U64 size { 0 };
+
+        static std::optional<SourceStamp> of(const Path &path) noexcept;
+
+        bool operator==(const SourceStamp &) const = default;
+    };
+
+    /**
+     * @brief Where the binary cube for sourcePath is cached: a photoView/luts directory under $XDG_CACHE_HOME, or
+     * ~/.cache if that's not set.
+     */
+    Path binaryCubePath(const Path &sourcePath) noexcept;
+
+    /**
+     * @brief Read a binary cube: a fixed header, the source path and title, then the raw F32 1D and 3D tables.
+     *
+     * Fails unless the cube was made from the given version of sourcePath.
+     */
+    Expected<CubeFile, CubeFileError>
+    readBinaryCube(const Path &path, const Path &sourcePath, const SourceStamp &stamp) noexcept;
+
+    /**
+     * @brief Write a binary cube. It's written to a temporary file and renamed, so readers never see part of one.
+     */
+    Expected<void, CubeFileError> writeBinaryCube(const Path &path,
+                                                  const CubeFile &cube,
+                                                  const Path &sourcePath,
+                                                  const SourceStamp &stamp) noexcept;
+
+}
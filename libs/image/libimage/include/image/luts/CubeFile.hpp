@@ -4,27 +4,73 @@
 #include <ostream>
 
 #include <image/CoreTypes.hpp>
+#include <image/Expected.hpp>
 #include <image/NDArray.hpp>
 #include <image/Color.hpp>
+#include <image/luts/Lattice1D.hpp>
 #include <image/luts/Lattice3D.hpp>
 
 namespace image::luts {
 
+    struct CubeFileError {
+        Path path;
+        String reason;
+    };
+
+    /**
+     * @brief A .cube file: a 3D table, a 1D table, or a 1D shaper table applied before a 3D table.
+     *
+     * A file's DOMAIN_MIN and DOMAIN_MAX apply to its first table. The 1D and 3D tables' domains can also be given by
+     * LUT_1D_INPUT_RANGE and LUT_3D_INPUT_RANGE, in which case DOMAIN_MIN and DOMAIN_MAX apply to the other table.
+     * Every channel's domain must be non-empty.
+     */
     struct CubeFile {
         CubeFile() noexcept {}
 
-        CubeFile(Lattice3D &lattice) noexcept;
-        
+        CubeFile(const Lattice3D &lattice) noexcept;
+
+        /**
+         * @brief The 3D table, with size 0 if there isn't one.
+         */
         Lattice3D lattice() const noexcept;
+
+        /**
+         * @brief The 1D table, with size 0 if there isn't one.
+         */
+        Lattice1D curves() const noexcept;
+
+        /**
+         * @brief Parse the text of a .cube file.
+         */
+        static Expected<CubeFile, CubeFileError> parse(StringView text) noexcept;
+
+        /**
+         * @brief Load a .cube file, going through the binary cube cache.
+         *
+         * The file is memory-mapped and parsed, and the result cached. Later loads of the same, unmodified file just
+         * copy the cached table out of its mapping.
+         */
+        static Expected<CubeFile, CubeFileError> load(const Path &path) noexcept;
+
+        /**
+         * @brief Write the cube to path as a .cube file.
+         */
+        Expected<void, CubeFileError> save(const Path &path) const noexcept;
         
         friend std::istream &operator>>(std::istream &input, CubeFile &data);
         friend std::ostream &operator<<(std::ostream &output, const CubeFile &data);
 
+        /// Nodes per side of the 3D table, or 0.
         std::size_t size { 0 };
+        /// Nodes in the 1D table, or 0.
+        std::size_t size1D { 0 };
         String title { "" };
         ColorRGB<F32> domainMin { 0.0f, 0.0f, 0.0f };
         ColorRGB<F32> domainMax { 1.0f, 1.0f, 1.0f };
+        ColorRGB<F32> domainMin1D { 0.0f, 0.0f, 0.0f };
+        ColorRGB<F32> domainMax1D { 1.0f, 1.0f, 1.0f };
         NDArray<ColorRGB<F32>> table { Shape{} };
+        NDArray<ColorRGB<F32>> table1D { Shape{} };
     };
 
 }
@@ -1,32 +1,50 @@
 #pragma once
 
-#include <concepts>
-
 #include <image/CoreTypes.hpp>
 #include <image/Color.hpp>
+#include <image/Expected.hpp>
+#include <image/IO.hpp>
 #include <image/ImageBuf.hpp>
-#include <image/NDArray.hpp>
+#include <image/luts/Lattice3D.hpp>
 
 namespace image {
 
-    template <class T1, std::unsigned_integral T2 = T1>
-    ImageBuf<T1> generateHald(std::size_t sizeClass) {
-        std::size_t lutSize = sizeClass * sizeClass;
-        std::size_t haldSize = lutSize * sizeClass;
-        std::size_t sizeBits = sizeof(T2) * 8;
-        std::size_t size = 1 << sizeBits;
-        std::size_t step = size / lutSize;
-
-        NDArray<ColorRGB<T1>> lut { Shape { lutSize, lutSize, lutSize }};
-        for (std::size_t b = 0; b < lutSize; ++b) {
-            for (std::size_t g = 0; g < lutSize; ++g) {
-                for (std::size_t r = 0; r < lutSize; ++r) {
-                    lut.at(r, g, b) = conv<T1, T2>(ColorRGB<T2>(r * step, g * step, b * step));
-                }
-            }
-        }
-        auto haldShape = Shape { haldSize, haldSize };
-        return ImageBuf<T1>{ lut.reshape(haldShape) };
-    }
+    /**
+     * @brief Write an identity Hald image of the given level to path, storing channels as format.
+     *
+     * Rows are generated in parallel a band at a time and written as they're generated, so memory use stays at a
+     * couple of bands however large the image is. Node i of n has the value i / (n - 1), as haldToLattice() expects.
+     */
+    Expected<void, ImageIOError> writeHaldToFile(const Path &path,
+                                                 std::size_t level,
+                                                 OIIO::TypeDesc format = OIIO::TypeDescFromC<U16>::value()) noexcept;
+
+    /**
+     * @brief Write lattice to path as a Hald image, streamed like the identity. lattice.size must be a square.
+     *
+     * The lattice's domain is taken to be [0, 1], the only domain Hald images have.
+     */
+    Expected<void, ImageIOError> writeHaldToFile(const Path &path,
+                                                 const luts::Lattice3D &lattice,
+                                                 OIIO::TypeDesc format = OIIO::TypeDescFromC<U16>::value()) noexcept;
+
+    /**
+     * @brief The number of lattice nodes per side of a Hald image with the given width, or 0 if it can't be one.
+     *
+     * A level L Hald image is L^3 pixels square and holds an L^2 node lattice.
+     */
+    std::size_t haldLatticeSize(memory::Size width) noexcept;
+
+    /**
+     * @brief Resample a Hald image's lattice to latticeSize nodes per side, interpolating trilinearly.
+     *
+     * Nodes are laid out along the image's rows with red varying fastest. Node i of n is the output for i / (n - 1).
+     */
+    luts::Lattice3D haldToLattice(const ImageBuf<U16> &image, std::size_t latticeSize) noexcept;
+
+    /**
+     * @brief Read a Hald image, such as a graded copy of one made by writeHaldToFile(), as a LUT.
+     */
+    Expected<luts::Lattice3D, ImageIOError> readHaldFromFile(const Path &path, std::size_t latticeSize) noexcept;
 
 }
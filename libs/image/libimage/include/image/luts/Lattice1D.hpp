@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+
+#include <image/CoreTypes.hpp>
+#include <image/NDArray.hpp>
+#include <image/Color.hpp>
+
+namespace image::luts {
+
+    /**
+     * @brief Per-channel curves: size nodes for each of red, green and blue, spread evenly over the domain.
+     */
+    struct Lattice1D {
+        /// Size of the curves separable filters are accumulated into for processing.
+        constexpr static const std::size_t PROCESSING_SIZE { 1024 };
+
+        Lattice1D() noexcept;
+        Lattice1D(std::size_t size) noexcept;
+
+        std::size_t size { 0 };
+        ColorRGB<F32> domainMin { 0.0f, 0.0f, 0.0f };
+        ColorRGB<F32> domainMax { 1.0f, 1.0f, 1.0f };
+        /// Node i holds each channel's output for the input i / (size - 1) of the way across its domain.
+        NDArray<ColorRGB<F32>> table { Shape{} };
+
+        /**
+         * @brief Replace every node with f(node). f must treat the channels independently.
+         */
+        template <class F>
+        void accumulate(F f) noexcept {
+            for (auto &node : table) { node = f(node); }
+        }
+
+        /**
+         * @brief Set every node to f of its input color. f must treat the channels independently.
+         */
+        template <class F>
+        void fromFunction(F f) noexcept {
+            auto step = 1.0f / static_cast<F32>(size - 1);
+            for (std::size_t i = 0; i < size; ++i) {
+                auto t = static_cast<F32>(i) * step;
+                table.at(i) = f(domainMin + (domainMax - domainMin) * t);
+            }
+        }
+
+        inline void loadIdentity() noexcept {
+            fromFunction([](const ColorRGB<F32> &color) { return color; });
+        }
+
+        /**
+         * @brief Interpolate each channel's curve linearly. Colors outside the domain are clamped to it.
+         */
+        ColorRGB<F32> map(const ColorRGB<F32> &color) const noexcept;
+
+        /**
+         * @brief Map count colors at once. The loop is written to be vectorised; in and out may be the same.
+         */
+        void map(const ColorRGB<F32> *in, ColorRGB<F32> *out, memory::Size count) const noexcept;
+    };
+
+}
@@ -5,10 +5,14 @@
 #include <image/CoreTypes.hpp>
 #include <image/NDArray.hpp>
 #include <image/Color.hpp>
+#include <image/ThreadPool.hpp>
 
 namespace image::luts {
     
     struct Lattice3D {
+        /// Size of the lattices filters are accumulated into for processing.
+        constexpr static const std::size_t PROCESSING_SIZE { 32 };
+
         Lattice3D() noexcept;
         Lattice3D(std::size_t size) noexcept;
     
@@ -17,9 +21,12 @@ namespace image::luts {
         ColorRGB<F32> domainMax { 1.0f, 1.0f, 1.0f };
         NDArray<ColorRGB<F32>> table { Shape{} };
 
+        /**
+         * @brief Replace every node with f(node). f is called from several threads at once.
+         */
         template <class F>
         void accumulate(F f) noexcept {
-            for (std::size_t b = 0 ; b < size ; ++b) {
+            ThreadPool::shared().parallelFor(size, [&](std::size_t b) {
                 for (std::size_t g = 0 ; g < size ; ++g) {
                     for (std::size_t r = 0 ; r < size ; ++r) {
                         auto &node = table.at(r, g, b);
@@ -27,14 +34,17 @@ namespace image::luts {
                         node = cOut;
                     }
                 }
-            }
+            }, 1);
         }
 
+        /**
+         * @brief Set every node to f of its input color. f is called from several threads at once.
+         */
         template <class F>
         void fromFunction(F f) noexcept {
             auto maxf = static_cast<F32>(size - 1);
             auto step = 1.0f / maxf;
-            for (std::size_t b = 0 ; b < size ; ++b) {
+            ThreadPool::shared().parallelFor(size, [&](std::size_t b) {
                 F32 bf = b * step;
                 for (std::size_t g = 0 ; g < size ; ++g) {
                     F32 gf = g * step;
@@ -45,7 +55,7 @@ namespace image::luts {
                         table.at(r, g, b) = cOut;
                     }
                 }
-            }
+            }, 1);
         }
 
         inline void loadIdentity() noexcept {
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include <image/CoreTypes.hpp>
+#include <image/Expected.hpp>
+#include <image/luts/BinaryCube.hpp>
+#include <image/luts/CubeFile.hpp>
+#include <image/luts/Lattice1D.hpp>
+#include <image/luts/Lattice3D.hpp>
+#include <image/luts/TetrahedralInterpolator.hpp>
+
+namespace image::luts {
+
+    struct LutLoadError {
+        Path path;
+        String reason;
+    };
+
+    /**
+     * @brief A LUT file's curves and lattice, with its interpolator ready to use.
+     *
+     * Either may be empty: a 1D LUT is just curves, and a 3D LUT may have curves as a shaper. Shared by everything
+     * that uses the same file, so it's never modified once loaded.
+     */
+    struct PreparedLut {
+        /// Applied first, if it has any nodes.
+        Lattice1D curves;
+        /// Applied after the curves, if it has any nodes.
+        Lattice3D lattice;
+        TetrahedralInterpolator interpolator;
+
+        /**
+         * @brief Whether the LUT is just curves, which treat each channel independently.
+         */
+        bool isSeparable() const noexcept { return lattice.size == 0; }
+
+        /**
+         * @brief Map count colors through the curves and then the lattice. in and out mustn't overlap.
+         */
+        void map(const ColorRGB<F32> *in, ColorRGB<F32> *out, memory::Size count) const noexcept;
+
+        /**
+         * @brief Approximate memory used by the curves, the lattice and the interpolator's tables.
+         */
+        memory::Size byteSize() const noexcept;
+    };
+
+    /**
+     * @brief Process-wide cache of prepared LUTs, keyed by path and modification time.
+     *
+     * Loading a file that's already cached and unchanged hands out the same PreparedLut, so filters and compositions
+     * using one LUT share its tables. When the cached LUTs take up more than capacity bytes, the least recently used
+     * are dropped from the cache. Anyone still holding one keeps it alive.
+     */
+    class LutCache {
+    public:
+        constexpr static const memory::Size DEFAULT_CAPACITY { 256 * 1024 * 1024 };
+
+        static LutCache &shared() noexcept;
+
+        explicit LutCache(memory::Size capacity = DEFAULT_CAPACITY) noexcept : capacity(capacity) {}
+
+        LutCache(const LutCache &) = delete;
+        LutCache &operator=(const LutCache &) = delete;
+
+        /**
+         * @brief Get the LUT at path, loading and preparing it if it isn't cached or the file has changed.
+         *
+         * .cube files are loaded as they are, 1D, 3D or both. Anything else is read as a Hald image, resampled to the
+         * processing lattice size.
+         */
+        Expected<std::shared_ptr<const PreparedLut>, LutLoadError> load(const Path &path) noexcept;
+
+        /**
+         * @brief Bytes taken up by the cached LUTs.
+         */
+        memory::Size byteSize() const noexcept;
+
+        void setCapacity(memory::Size bytes) noexcept;
+
+        void clear() noexcept;
+
+    private:
+        struct Entry {
+            Path path;
+            SourceStamp stamp;
+            std::shared_ptr<const PreparedLut> lut;
+            memory::Size bytes;
+        };
+
+        mutable std::mutex mutex;
+        memory::Size capacity;
+        memory::Size bytes { 0 };
+        /// Most recently used first.
+        std::list<Entry> entries;
+        std::unordered_map<String, std::list<Entry>::iterator> index;
+
+        void erase(std::list<Entry>::iterator it) noexcept;
+        void evict() noexcept;
+    };
+
+}
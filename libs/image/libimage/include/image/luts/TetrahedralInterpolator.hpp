@@ -1,15 +1,19 @@
 #pragma once
 
-#include <optional>
+#include <vector>
 
 #include <image/CoreTypes.hpp>
 #include <image/Color.hpp>
-#include <image/NDArray.hpp>
 #include <image/luts/Lattice3D.hpp>
-#include <image/luts/SimpleCube.hpp>
 
 namespace image::luts {
-    
+
+    /**
+     * @brief Tetrahedral interpolation of a Lattice3D.
+     *
+     * Inputs are placed in the lattice's domain, and clamped to it. Once loaded, the interpolator is never modified
+     * by mapping, so it can be used from any number of threads.
+     */
     class TetrahedralInterpolator {
     public:
         using InType = F32;
@@ -19,14 +23,23 @@ namespace image::luts {
 
         ColorRGB<OutType> map(const ColorRGB<InType>& color) const noexcept;
 
-    protected:
-        const SimpleCube &findCube(ColorRGB<InType> color) const;
+        /**
+         * @brief Map count colors at once. The loop is written to be vectorised; in and out mustn't overlap.
+         */
+        void map(const ColorRGB<InType> *in, ColorRGB<OutType> *out, memory::Size count) const noexcept;
+
+        /**
+         * @brief Memory used by the interpolator's copy of the lattice.
+         */
+        memory::Size byteSize() const noexcept { return table.size() * sizeof(ColorRGB<OutType>); }
 
     private:
-        NDArray<SimpleCube> cubeTable { Shape{} };
+        /// Lattice nodes, red varying fastest.
+        std::vector<ColorRGB<OutType>> table;
         std::size_t latticeSize { 0 };
-        mutable ColorRGB<InType> inCache { -1.0f };
-        mutable ColorRGB<OutType> outCache { -1.0f };
+        /// Take inputs from the domain to node coordinates.
+        ColorRGB<F32> inputScale { 1.0f, 1.0f, 1.0f };
+        ColorRGB<F32> inputOffset { 0.0f, 0.0f, 0.0f };
     };
 
 }
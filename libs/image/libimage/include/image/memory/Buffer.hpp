@@ -10,6 +10,19 @@ namespace image::memory {
 
     struct Buffer;
 
+    /**
+     * @brief A 2D sub-region of a buffer treated as rows of rowPitch bytes.
+     *
+     * x and width are in bytes, y and height are in rows.
+     */
+    struct BufferRect {
+        Size x { 0 };
+        Size y { 0 };
+        Size width { 0 };
+        Size height { 0 };
+        Size rowPitch { 0 };
+    };
+
     struct AbstractDevice {
         Size size;
 
@@ -19,6 +32,21 @@ namespace image::memory {
         virtual void copyDeviceToHost(Buffer &) noexcept = 0;
         virtual void copyHostToDevice(Buffer &) noexcept = 0;
 
+        /**
+         * @brief Copy only the given region of the host block to the device.
+         *
+         * The copy may still be in progress when this returns, so the region must be left as it is until sync().
+         * Devices without support for partial copies fall back to copying the whole buffer.
+         */
+        virtual void copyHostToDeviceRect(Buffer &buf, const BufferRect &) noexcept { copyHostToDevice(buf); }
+
+        /**
+         * @brief Copy only the given region of the device block to the host.
+         *
+         * Devices without support for partial copies fall back to copying the whole buffer.
+         */
+        virtual void copyDeviceToHostRect(Buffer &buf, const BufferRect &) noexcept { copyDeviceToHost(buf); }
+
         virtual ~AbstractDevice() noexcept {}
     };
 
@@ -34,7 +62,9 @@ namespace image::memory {
         constexpr void *data() noexcept { return hostBlock.ptr; }
 
         inline void malloc() noexcept {
-            hostBlock = allocator->alloc(size);
+            // Plain allocations are already aligned for any scalar, so only ask for more when it's needed.
+            hostBlock = alignment > alignof(std::max_align_t) ? allocator->alignedAlloc(size, alignment)
+                                                              : allocator->alloc(size);
             ownsHostBlock = true;
         }
 
@@ -64,12 +94,31 @@ namespace image::memory {
             device->copyDeviceToHost(*this);
         }
 
+        inline void copyDeviceToHost(const BufferRect &rect) noexcept {
+            assert(device);
+            assert(hostBlock);
+            assert((rect.y + rect.height) * rect.rowPitch <= size);
+            device->copyDeviceToHostRect(*this, rect);
+        }
+
         inline void copyHostToDevice() noexcept {
             assert(device);
             assert(hostBlock);
             device->copyHostToDevice(*this);
         }
 
+        inline void sync() noexcept {
+            assert(device);
+            device->sync(*this);
+        }
+
+        inline void copyHostToDevice(const BufferRect &rect) noexcept {
+            assert(device);
+            assert(hostBlock);
+            assert((rect.y + rect.height) * rect.rowPitch <= size);
+            device->copyHostToDeviceRect(*this, rect);
+        }
+
         constexpr explicit Buffer() noexcept {}
 
         constexpr explicit Buffer(Block block) noexcept : hostBlock(block), size(block.size), allocator(nullptr) {}
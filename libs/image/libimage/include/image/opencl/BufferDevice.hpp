@@ -8,6 +8,8 @@
 #include <CL/cl.h>
 #endif
 
+#include <array>
+
 #include <image/SmallVector.hpp>
 #include <image/memory/Buffer.hpp>
 #include <image/opencl/Context.hpp>
@@ -30,13 +32,21 @@ namespace image::memory {
 
         void copyHostToDevice(Buffer &buf) noexcept override;
 
+        void copyHostToDeviceRect(Buffer &buf, const BufferRect &rect) noexcept override;
+
+        void copyDeviceToHostRect(Buffer &buf, const BufferRect &rect) noexcept override;
+
         explicit OpenCLDevice(const opencl::ContextHandle &ctx, const opencl::CommandQueueHandle &queue) noexcept;
     };
 
+    /**
+     * @brief Stores buffers as OpenCL images. imageSize has two dimensions for a 2D image and three for a 3D one.
+     */
     struct OpenCLImageDevice final : public AbstractDevice {
         opencl::ContextHandle ctx;
         opencl::CommandQueueHandle queue;
         SmallVector<Size, 3> imageSize;
+        cl_image_format format { CL_RGBA, CL_FLOAT };
 
         void malloc(Buffer &buf) noexcept override;
 
@@ -48,11 +58,18 @@ namespace image::memory {
 
         void copyHostToDevice(Buffer &buf) noexcept override;
 
+        void copyHostToDeviceRect(Buffer &buf, const BufferRect &rect) noexcept override;
+
         explicit OpenCLImageDevice(
             const opencl::ContextHandle &ctx,
             const opencl::CommandQueueHandle &queue,
-            const SmallVectorImpl<Size> &imageSize
+            const SmallVectorImpl<Size> &imageSize,
+            const cl_image_format &format = { CL_RGBA, CL_FLOAT }
         ) noexcept;
+
+    private:
+        std::array<std::size_t, 3> region() const noexcept;
+        Size pixelSize() const noexcept;
     };
 
 }
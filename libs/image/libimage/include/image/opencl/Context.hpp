@@ -85,6 +85,7 @@ namespace image::opencl {
         bool imageSupport;
         cl_uint maxComputeUnits;
         cl_uint maxWorkItemDims;
+        size_t maxWorkGroupSize;
     };
 
     struct Platform {
@@ -2,6 +2,8 @@
 
 #include <map>
 #include <memory>
+#include <mutex>
+#include <utility>
 
 #include <image/Expected.hpp>
 
@@ -23,9 +25,15 @@ namespace image::opencl {
         CommandQueue queue;
         std::shared_ptr<memory::OpenCLDevice> bufferDevice;
 
-        Expected<Program, Error> programFromResource(const String &filename) noexcept;
+        /**
+         * @brief Build a program from a resource file, or get the one built before with the same options.
+         */
+        Expected<Program, Error> programFromResource(const String &filename, const String &options = "") noexcept;
 
-        std::map<String, Program> programs;
+        /// Built programs, keyed by file name and build options.
+        std::map<std::pair<String, String>, Program> programs;
+        /// Guards programs: processors on other threads, such as export jobs, build programs too.
+        std::mutex programsMutex;
 
         static Manager *the() noexcept;
 
@@ -22,6 +22,8 @@ namespace image::opencl {
         KernelHandle handle;
 
         cl_uint getNumArgs() const noexcept;
+        /// The largest work-group the kernel can be run with on device, given the resources it uses.
+        size_t getWorkGroupSize(cl_device_id device) const noexcept;
 
         template <class T>
         requires std::integral<T> || std::floating_point<T>
@@ -60,6 +62,8 @@ namespace image::opencl {
         }
 
         Expected<void, Error> run(const CommandQueueHandle &queue, const Shape &globalWorkShape) noexcept;
+        Expected<void, Error>
+        run(const CommandQueueHandle &queue, const Shape &globalWorkShape, const Shape &localWorkShape) noexcept;
     };
 
     struct Program {
@@ -67,7 +71,10 @@ namespace image::opencl {
 
         static Expected<Program, Error> fromSource(const Context &ctx, const String &src) noexcept;
 
-        Expected<void, Error> build() noexcept;
+        /**
+         * @brief Build for every device in the context. options are passed to the compiler, e.g. -D definitions.
+         */
+        Expected<void, Error> build(const String &options = "") noexcept;
 
         Expected<Kernel, Error> getKernel(const String &name) noexcept;
     };
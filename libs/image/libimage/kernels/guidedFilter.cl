@@ -0,0 +1,133 @@
+__kernel void guidedFilter_guide_F32(
+    __global const float *inputImage,
+    uint imagePitch,
+    uint imageWidth,
+    uint imageHeight,
+    uint width,
+    uint divisor,
+    __global float *guide
+) {
+    uint x = get_global_id(0);
+    uint y = get_global_id(1);
+
+    // Must match downsampleLuma: average the 2x2 pixels at the centre of the block this pixel covers.
+    uint x0 = min(x * divisor + (divisor - 1) / 2, imageWidth - 1);
+    uint x1 = min(x * divisor + divisor / 2, imageWidth - 1);
+    uint y0 = min(y * divisor + (divisor - 1) / 2, imageHeight - 1);
+    uint y1 = min(y * divisor + divisor / 2, imageHeight - 1);
+    __global const float *row0 = inputImage + y0 * imagePitch;
+    __global const float *row1 = inputImage + y1 * imagePitch;
+    float3 color = vload3(x0, row0) + vload3(x1, row0) + vload3(x0, row1) + vload3(x1, row1);
+    guide[y * width + x] = (color.x + color.y + color.z) / 12.0f;
+}
+
+__kernel void guidedFilter_downsample_F32(
+    __global const float *guide,
+    __global const float *mask,
+    uint width,
+    uint height,
+    uint subsampling,
+    __global float4 *stats
+) {
+    uint x = get_global_id(0);
+    uint y = get_global_id(1);
+    uint lowWidth = get_global_size(0);
+
+    float i = 0;
+    float p = 0;
+    uint n = 0;
+    for (uint yy = y * subsampling; yy < min(y * subsampling + subsampling, height); ++yy) {
+        for (uint xx = x * subsampling; xx < min(x * subsampling + subsampling, width); ++xx) {
+            i += guide[yy * width + xx];
+            p += mask[yy * width + xx];
+            ++n;
+        }
+    }
+    i /= n;
+    p /= n;
+    stats[y * lowWidth + x] = (float4)(i, p, i * i, i * p);
+}
+
+// One work item per row. Running sums keep the cost independent of the radius.
+__kernel void boxFilterRows_F32x4(
+    __global const float4 *input,
+    __global float4 *output,
+    uint width,
+    uint radius
+) {
+    size_t y = get_global_id(0);
+    __global const float4 *in = input + y * width;
+    __global float4 *out = output + y * width;
+
+    float4 sum = 0;
+    for (uint x = 0; x <= min(radius, width - 1); ++x) {
+        sum += in[x];
+    }
+    for (uint x = 0; x < width; ++x) {
+        uint lo = x >= radius ? x - radius : 0;
+        uint count = min(x + radius, width - 1) - lo + 1;
+        out[x] = sum / (float)count;
+        if (x + radius + 1 < width) { sum += in[x + radius + 1]; }
+        if (x >= radius) { sum -= in[x - radius]; }
+    }
+}
+
+// One work item per column, so neighbouring work items read neighbouring pixels.
+__kernel void boxFilterColumns_F32x4(
+    __global const float4 *input,
+    __global float4 *output,
+    uint width,
+    uint height,
+    uint radius
+) {
+    size_t x = get_global_id(0);
+
+    float4 sum = 0;
+    for (uint y = 0; y <= min(radius, height - 1); ++y) {
+        sum += input[y * width + x];
+    }
+    for (uint y = 0; y < height; ++y) {
+        uint lo = y >= radius ? y - radius : 0;
+        uint count = min(y + radius, height - 1) - lo + 1;
+        output[y * width + x] = sum / (float)count;
+        if (y + radius + 1 < height) { sum += input[(y + radius + 1) * width + x]; }
+        if (y >= radius) { sum -= input[(y - radius) * width + x]; }
+    }
+}
+
+__kernel void guidedFilter_coefficients_F32(
+    __global float4 *stats,
+    float epsilon
+) {
+    size_t globalId = get_global_id(0);
+
+    // stats = (mean I, mean p, mean I^2, mean I*p). Replaced by the coefficients (a, b) of p = a * I + b.
+    float4 m = stats[globalId];
+    float variance = m.z - m.x * m.x;
+    float covariance = m.w - m.x * m.y;
+    float a = covariance / (variance + epsilon);
+    stats[globalId] = (float4)(a, m.y - a * m.x, 0, 0);
+}
+
+__kernel void guidedFilter_output_F32(
+    __global const float *guide,
+    __global const float4 *coefficients,
+    uint width,
+    uint lowWidth,
+    uint lowHeight,
+    uint subsampling,
+    __global float *mask
+) {
+    uint x = get_global_id(0);
+    uint y = get_global_id(1);
+
+    float2 lowMax = (float2)(lowWidth - 1, lowHeight - 1);
+    float2 pos = clamp(((float2)(x, y) + 0.5f) / subsampling - 0.5f, (float2)(0), lowMax);
+    uint2 p0 = convert_uint2(pos);
+    uint2 p1 = min(p0 + 1, convert_uint2(lowMax));
+    float2 t = pos - floor(pos);
+    float4 top = mix(coefficients[p0.y * lowWidth + p0.x], coefficients[p0.y * lowWidth + p1.x], t.x);
+    float4 bottom = mix(coefficients[p1.y * lowWidth + p0.x], coefficients[p1.y * lowWidth + p1.x], t.x);
+    float4 c = mix(top, bottom, t.y);
+    mask[y * width + x] = clamp(c.x * guide[y * width + x] + c.y, 0.0f, 1.0f);
+}
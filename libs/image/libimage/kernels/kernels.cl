@@ -1,41 +1,307 @@
+// LUTs are either 3D images, sampled with linear filtering by the device's texture hardware, or plain buffers of
+// float4 nodes interpolated here. Define LUT_BUFFER when building to use buffers. Define LUT_CURVES instead to build
+// the kernels to apply per-channel curves, for ops made of separable filters. MASK_GAMMA is always defined by the
+// Processor, from the host's maskGamma.
+#if defined(LUT_CURVES)
+
+// Linear interpolation in one channel's curve. Each channel costs one gather of two neighbouring nodes, rather than
+// the eight a 3D lookup takes.
+float lookupCurve(__global const float *curve, uint curveSize, float x) {
+    float scale = (float)(curveSize - 1);
+    float coord = clamp(x * scale, 0.0f, scale);
+    uint i = min(convert_uint(coord), curveSize - 2);
+    float2 nodes = vload2(0, curve + i);
+    return mix(nodes.x, nodes.y, coord - (float)i);
+}
+
+// The curves are stored one channel after another.
+#define LUT_PARAMS __global const float *curves, uint curveSize
+#define LUT_LOOKUP(color) (float3)(lookupCurve(curves, curveSize, (color).x), \
+                                   lookupCurve(curves + curveSize, curveSize, (color).y), \
+                                   lookupCurve(curves + 2 * curveSize, curveSize, (color).z))
+
+#elif defined(LUT_BUFFER)
+
+// Tetrahedral interpolation, as luts::TetrahedralInterpolator. Nodes are stored red fastest.
+float3 lookupLut(__global const float4 *lut, uint lutSize, float3 color) {
+    float scale = (float)(lutSize - 1);
+    float3 coord = clamp(color * scale, 0.0f, scale);
+    uint3 base = min(convert_uint3(coord), (uint3)(lutSize - 2));
+    float3 f = coord - convert_float3(base);
+    uint sr = 1;
+    uint sg = lutSize;
+    uint sb = lutSize * lutSize;
+    uint i0 = base.x * sr + base.y * sg + base.z * sb;
+
+    // Walk from the cell's first corner along the axes from largest fraction to smallest. Ties are broken in opposite
+    // orders, so the largest and smallest axes always differ.
+    bool rIsMax = f.x >= f.y && f.x >= f.z;
+    bool gIsMax = !rIsMax && f.y >= f.z;
+    bool bIsMin = f.z <= f.y && f.z <= f.x;
+    bool gIsMin = !bIsMin && f.y <= f.x;
+    uint maxStride = rIsMax ? sr : (gIsMax ? sg : sb);
+    uint minStride = bIsMin ? sb : (gIsMin ? sg : sr);
+    float fMax = max(f.x, max(f.y, f.z));
+    float fMin = min(f.x, min(f.y, f.z));
+    float fMid = f.x + f.y + f.z - fMax - fMin;
+
+    float4 c0 = lut[i0];
+    float4 c1 = lut[i0 + maxStride];
+    float4 c2 = lut[i0 + sr + sg + sb - minStride];
+    float4 c3 = lut[i0 + sr + sg + sb];
+    return ((1.0f - fMax) * c0 + (fMax - fMid) * c1 + (fMid - fMin) * c2 + fMin * c3).xyz;
+}
+
+#define LUT_PARAMS __global const float4 *lut, uint lutSize
+#define LUT_LOOKUP(color) lookupLut(lut, lutSize, (color))
+
+#else
+
+// With normalised coordinates the texel centres are at (i + 0.5) / N, but node i is meant for colour i / (N - 1), as in
+// the buffer lookup. Remap so that 0 and 1 land on the centres of the first and last nodes. The hardware still filters
+// trilinearly, so results are close to the tetrahedral lookup between nodes rather than identical.
+float3 lookupLutImage(__read_only image3d_t lutImage, sampler_t lutSampler, float3 color) {
+    float n = (float)get_image_width(lutImage);
+    float3 coord = clamp(color, 0.0f, 1.0f) * ((n - 1.0f) / n) + 0.5f / n;
+    return read_imagef(lutImage, lutSampler, (float4)(coord, 0)).xyz;
+}
+
+#define LUT_PARAMS __read_only image3d_t lutImage, sampler_t lutSampler
+#define LUT_LOOKUP(color) lookupLutImage(lutImage, lutSampler, (color))
+
+#endif
+
+// Image kernels run with a work item per pixel, over (width, height). Rows of images are pitch elements apart, which
+// is more than their width when they're padded to be aligned, while masks are packed.
+
 __kernel void apply3DLut_F32_F32(
-    __read_only image3d_t lutImage,
-    sampler_t lutSampler,
+    LUT_PARAMS,
     __global const float *inputImage,
+    uint pitch,
     __global float *outputImage
 ) {
-    size_t globalId = get_global_id(0);
+    uint x = get_global_id(0);
+    size_t row = get_global_id(1) * pitch;
 
-    float3 colorIn = vload3(globalId, inputImage);
-    float4 lutCoord = (float4)(colorIn, 0);
-    float4 lutValue = read_imagef(lutImage, lutSampler, lutCoord);
-    float3 colorOut = lutValue.xyz;
-    vstore3(colorOut, globalId, outputImage);
+    float3 colorIn = vload3(x, inputImage + row);
+    float3 lutValue = LUT_LOOKUP(colorIn);
+    float3 colorOut = lutValue;
+    vstore3(colorOut, x, outputImage + row);
 }
 
 __kernel void apply3DLut_masked_F32_F32(
-    __read_only image3d_t lutImage,
-    sampler_t lutSampler,
+    LUT_PARAMS,
     __global const float *inputImage,
+    uint pitch,
     __global const float *inputMask,
     __global float *outputImage
 ) {
-    size_t globalId = get_global_id(0);
+    uint x = get_global_id(0);
+    size_t row = get_global_id(1) * pitch;
+    size_t maskId = get_global_id(1) * get_global_size(0) + x;
 
-    float3 colorIn = vload3(globalId, inputImage);
-    float4 lutCoord = (float4)(colorIn, 0);
-    float4 lutValue = read_imagef(lutImage, lutSampler, lutCoord);
-    float maskFactor = pow(inputMask[globalId], 2.2f); // Gamma uncorrect mask.
-    float3 colorOut = (lutValue.xyz * maskFactor) + (colorIn * (1 - maskFactor));
-    vstore3(colorOut, globalId, outputImage);
+    float3 colorIn = vload3(x, inputImage + row);
+    float3 lutValue = LUT_LOOKUP(colorIn);
+    float maskFactor = inputMask[maskId]; // Already linearised by PackedMask.
+    float3 colorOut = (lutValue * maskFactor) + (colorIn * (1 - maskFactor));
+    vstore3(colorOut, x, outputImage + row);
 }
 
+__kernel void apply3DLut_maskedF16_F32_F32(
+    LUT_PARAMS,
+    __global const float *inputImage,
+    uint pitch,
+    __global const half *inputMask,
+    __global float *outputImage
+) {
+    uint x = get_global_id(0);
+    size_t row = get_global_id(1) * pitch;
+    size_t maskId = get_global_id(1) * get_global_size(0) + x;
+
+    float3 colorIn = vload3(x, inputImage + row);
+    float3 lutValue = LUT_LOOKUP(colorIn);
+    float maskFactor = vload_half(maskId, inputMask); // Already linearised by PackedMask.
+    float3 colorOut = (lutValue * maskFactor) + (colorIn * (1 - maskFactor));
+    vstore3(colorOut, x, outputImage + row);
+}
+
+__kernel void apply3DLut_maskedU8_F32_F32(
+    LUT_PARAMS,
+    __global const float *inputImage,
+    uint pitch,
+    __global const uchar *inputMask,
+    __global float *outputImage
+) {
+    uint x = get_global_id(0);
+    size_t row = get_global_id(1) * pitch;
+    size_t maskId = get_global_id(1) * get_global_size(0) + x;
+
+    float3 colorIn = vload3(x, inputImage + row);
+    float3 lutValue = LUT_LOOKUP(colorIn);
+    float maskFactor = inputMask[maskId] / 255.0f; // Already linearised by PackedMask.
+    float3 colorOut = (lutValue * maskFactor) + (colorIn * (1 - maskFactor));
+    vstore3(colorOut, x, outputImage + row);
+}
+
+__kernel void apply3DLut_maskedImage_F32_F32(
+    LUT_PARAMS,
+    __global const float *inputImage,
+    uint pitch,
+    __read_only image2d_t maskImage,
+    sampler_t maskSampler,
+    float maskScale,
+    __global float *outputImage
+) {
+    uint x = get_global_id(0);
+    uint y = get_global_id(1);
+    size_t row = y * pitch;
+
+    float3 colorIn = vload3(x, inputImage + row);
+    float3 lutValue = LUT_LOOKUP(colorIn);
+    // Mask pixels cover maskScale^-1 image pixels each; sample at this pixel's centre in mask pixels.
+    float2 maskCoord = ((float2)(x, y) + 0.5f) * maskScale;
+    float maskFactor = read_imagef(maskImage, maskSampler, maskCoord).x; // Already linearised by PackedMask.
+    float3 colorOut = (lutValue * maskFactor) + (colorIn * (1 - maskFactor));
+    vstore3(colorOut, x, outputImage + row);
+}
+
+#define PROCEDURAL_MASK_LINEAR_GRADIENT 1
+
+float evaluateProceduralMask(int maskKind, float2 pos, float4 maskParams) {
+    if (maskKind == PROCEDURAL_MASK_LINEAR_GRADIENT) {
+        // maskParams = (a, b, c1, c2). See LinearGradientProjection.
+        float proj = maskParams.x * pos.x + maskParams.y * pos.y;
+        if (proj <= maskParams.z) { return 0; }
+        if (proj >= maskParams.w) { return 1; }
+        return (proj - maskParams.z) / (maskParams.w - maskParams.z);
+    }
+    return 0;
+}
+
+__kernel void apply3DLut_procedural_F32_F32(
+    LUT_PARAMS,
+    __global const float *inputImage,
+    uint pitch,
+    int maskKind,
+    float maskParam0,
+    float maskParam1,
+    float maskParam2,
+    float maskParam3,
+    __global float *outputImage
+) {
+    uint x = get_global_id(0);
+    uint y = get_global_id(1);
+    size_t row = y * pitch;
+
+    float3 colorIn = vload3(x, inputImage + row);
+    float3 lutValue = LUT_LOOKUP(colorIn);
+    float2 pos = (float2)(x, y) / (float2)(get_global_size(0), get_global_size(1));
+    float4 maskParams = (float4)(maskParam0, maskParam1, maskParam2, maskParam3);
+    float maskFactor = pow(evaluateProceduralMask(maskKind, pos, maskParams), MASK_GAMMA); // Gamma uncorrect mask.
+    float3 colorOut = (lutValue * maskFactor) + (colorIn * (1 - maskFactor));
+    vstore3(colorOut, x, outputImage + row);
+}
+
+// Must match TiledMask.
+#define MASK_TILE_SIZE 64
+#define MASK_TILE_EMPTY -1
+#define MASK_TILE_FULL -2
+
+__kernel void apply3DLut_tiled_F32_F32(
+    LUT_PARAMS,
+    __global const float *inputImage,
+    uint pitch,
+    __global const int *tileTable,
+    uint tilesX,
+    __global const float *tilePool,
+    __global float *outputImage
+) {
+    uint x = get_global_id(0);
+    uint y = get_global_id(1);
+    size_t row = y * pitch;
+
+    float3 colorIn = vload3(x, inputImage + row);
+    int slot = tileTable[(y / MASK_TILE_SIZE) * tilesX + (x / MASK_TILE_SIZE)];
+    if (slot == MASK_TILE_EMPTY) {
+        // Nothing to apply; skip the LUT lookup entirely.
+        vstore3(colorIn, x, outputImage + row);
+        return;
+    }
+    float3 lutValue = LUT_LOOKUP(colorIn);
+    if (slot == MASK_TILE_FULL) {
+        vstore3(lutValue, x, outputImage + row);
+        return;
+    }
+    size_t tileOffset = (size_t)slot * MASK_TILE_SIZE * MASK_TILE_SIZE;
+    size_t maskIdx = tileOffset + (y % MASK_TILE_SIZE) * MASK_TILE_SIZE + (x % MASK_TILE_SIZE);
+    float maskFactor = tilePool[maskIdx]; // Tiles are stored linearised.
+    float3 colorOut = (lutValue * maskFactor) + (colorIn * (1 - maskFactor));
+    vstore3(colorOut, x, outputImage + row);
+}
+
+// Channels are scaled by 256 and saturated, so values of 1 and up come out as 255, as TiledExecutor's quantize().
 __kernel void finalize_F32_U8(
     __global const float *inputImage,
-    __global uchar *outputImage
+    uint inputPitch,
+    __global uchar *outputImage,
+    uint outputPitch
+) {
+    uint x = get_global_id(0);
+    size_t y = get_global_id(1);
+
+    float3 color = vload3(x, inputImage + y * inputPitch);
+    vstore3(convert_uchar3_sat(color * 256), x, outputImage + y * outputPitch);
+}
+
+// Must match the bucket count of the Processor's histogram.
+#define HISTOGRAM_BUCKETS 256
+
+// Run with a fixed number of work-groups: each work item finalises every get_global_size(0)-th pixel. Each group
+// counts into local memory and writes its bins out once at the end.
+__kernel void finalizeHistogram_F32_U8(
+    __global const float *inputImage,
+    uint inputPitch,
+    __global uchar *outputImage,
+    uint outputPitch,
+    uint width,
+    uint numPixels,
+    __global uint *partialBins
+) {
+    __local uint bins[3 * HISTOGRAM_BUCKETS];
+    for (uint i = get_local_id(0); i < 3 * HISTOGRAM_BUCKETS; i += get_local_size(0)) {
+        bins[i] = 0;
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    for (size_t globalId = get_global_id(0); globalId < numPixels; globalId += get_global_size(0)) {
+        uint x = globalId % width;
+        size_t y = globalId / width;
+        float3 color = vload3(x, inputImage + y * inputPitch);
+        uchar3 colorOut = convert_uchar3_sat(color * 256);
+        vstore3(colorOut, x, outputImage + y * outputPitch);
+        atomic_inc(&bins[colorOut.x]);
+        atomic_inc(&bins[HISTOGRAM_BUCKETS + colorOut.y]);
+        atomic_inc(&bins[2 * HISTOGRAM_BUCKETS + colorOut.z]);
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    __global uint *groupBins = partialBins + get_group_id(0) * 3 * HISTOGRAM_BUCKETS;
+    for (uint i = get_local_id(0); i < 3 * HISTOGRAM_BUCKETS; i += get_local_size(0)) {
+        groupBins[i] = bins[i];
+    }
+}
+
+// One work item per bucket, summing that bucket over every group's partial bins.
+__kernel void reduceHistogram_U32(
+    __global const uint *partialBins,
+    uint numGroups,
+    __global uint *bins
 ) {
-    size_t globalId = get_global_id(0);
+    size_t bucket = get_global_id(0);
 
-    float3 color = vload3(globalId, inputImage);
-    vstore3(convert_uchar3(color * 256), globalId, outputImage);
+    uint sum = 0;
+    for (uint group = 0; group < numGroups; ++group) {
+        sum += partialBins[group * 3 * HISTOGRAM_BUCKETS + bucket];
+    }
+    bins[bucket] = sum;
 }
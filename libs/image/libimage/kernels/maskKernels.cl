@@ -1,10 +1,13 @@
+// Run over (width, height). The mask is packed, and the overlay's rows are outputPitch bytes apart.
 __kernel void generate_overlay_image_F32_U8(
     __global const float *inputMask,
-    __global uchar *outputImage
+    __global uchar *outputImage,
+    uint outputPitch
 ) {
-    size_t globalId = get_global_id(0);
+    uint x = get_global_id(0);
+    size_t y = get_global_id(1);
 
-    float maskFactor = inputMask[globalId];
+    float maskFactor = inputMask[y * get_global_size(0) + x];
     float4 maskColor = (float4)(1.0f, 0.0f, 0.0f, maskFactor);
-    vstore4(convert_uchar4(maskColor * 256), globalId, outputImage);
+    vstore4(convert_uchar4_sat(maskColor * 256), x, outputImage + y * outputPitch);
 }
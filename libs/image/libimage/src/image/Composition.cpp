@@ -42,10 +42,13 @@ namespace image {
         std::cerr << "========================\n";
     }
 
-    Expected<Composition, CompositionCreationError> Composition::newFromPath(const Path &path) noexcept {
+    Expected<Composition, CompositionCreationError>
+    Composition::newFromPath(const Path &path,
+                             std::shared_ptr<memory::AbstractDevice> device,
+                             const ImageReadOptions &opts) noexcept {
         Composition comp;
         comp.inputImage.setPath(path);
-        auto loadResult = comp.inputImage.load();
+        auto loadResult = comp.inputImage.load(device, opts);
         if (loadResult.hasError()) { return Unexpected(CompositionCreationError { path }); }
         comp.layers.push_back(std::make_shared<Layer>());
         return comp;
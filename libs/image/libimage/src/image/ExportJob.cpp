@@ -0,0 +1,106 @@
+#include <image/ExportJob.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <future>
+#include <optional>
+
+#include <image/Processor.hpp>
+#include <image/Serialization.hpp>
+#include <image/Stopwatch.hpp>
+
+namespace image {
+
+    namespace {
+        OIIO::TypeDesc typeFor(ExportDepth depth) noexcept {
+            switch (depth) {
+            case ExportDepth::U16:
+                return OIIO::TypeDescFromC<U16>::value();
+            case ExportDepth::F32:
+                return OIIO::TypeDescFromC<F32>::value();
+            case ExportDepth::U8:
+                break;
+            }
+            return OIIO::TypeDescFromC<U8>::value();
+        }
+    }
+
+    ExportDepth defaultExportDepth(const Path &path) noexcept {
+        auto ext = path.extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+        if (ext == ".exr" || ext == ".hdr") { return ExportDepth::F32; }
+        if (ext == ".tif" || ext == ".tiff" || ext == ".png") { return ExportDepth::U16; }
+        return ExportDepth::U8;
+    }
+
+    ExportJob::ExportJob(std::shared_ptr<Composition> comp,
+                         const Path &path,
+                         const ExportOptions &opts,
+                         FinishedCallback onFinished) noexcept
+      // Work on a deep copy, made here on the caller's thread, so that interactive edits to the layers, filters and
+      // masks, or swapping in a new input, don't touch what the job is reading.
+      : composition(std::make_shared<Composition>(serialization::copyComposition(*comp)))
+      , path(path)
+      , opts(opts)
+      , onFinished(std::move(onFinished)) {
+        thread = std::thread([this] {
+            auto result = run();
+            isFinished_ = true;
+            if (this->onFinished) { this->onFinished(result); }
+        });
+    }
+
+    ExportJob::~ExportJob() noexcept {
+        if (thread.joinable()) { thread.join(); }
+    }
+
+    ExportJob::Result ExportJob::run() noexcept {
+        STOPWATCH("Exporting image");
+        auto &inputImage = composition->inputImage;
+        if (inputImage.isReduced) {
+            auto full = readImageBufFromFile<F32>(*inputImage.filePath, ImageReadOptions { .halfSize = false });
+            if (full.hasError()) { return Unexpected(full.error()); }
+            inputImage.data = std::move(*full);
+            inputImage.isReduced = false;
+        }
+
+        Processor processor;
+        processor.init();
+        processor.setComposition(composition);
+        processor.update();
+        std::optional<PoolLease<ImageBuf<F32>>> lease;
+        auto &result = processor.render(lease);
+
+        memory::Size width = result.width();
+        memory::Size height = result.height();
+        auto out = OIIO::ImageOutput::create(path.string());
+        if (!out) { return Unexpected(ImageIOError(path, OIIO::geterror())); }
+        OIIO::ImageSpec spec(width, height, 3, typeFor(opts.depth));
+        if (!out->open(path.string(), spec)) { return Unexpected(ImageIOError(path, out->geterror())); }
+
+        // Each band is encoded while the next one is read back. Bands must still be written in order, so only one
+        // write is ever in flight.
+        std::future<bool> pendingWrite;
+        memory::Size rowBytes = result.rowPitchBytes();
+        for (memory::Size row = 0; row < height; row += BAND_HEIGHT) {
+            memory::Size numRows = std::min(BAND_HEIGHT, height - row);
+            result.pixelArray.buffer()->copyDeviceToHost(memory::BufferRect { 0, row, rowBytes, numRows, rowBytes });
+            if (pendingWrite.valid() && !pendingWrite.get()) {
+                return Unexpected(ImageIOError(path, out->geterror()));
+            }
+            const F32 *band = result.row(row);
+            int yBegin = static_cast<int>(row);
+            int yEnd = static_cast<int>(row + numRows);
+            pendingWrite = std::async(std::launch::async, [&out, yBegin, yEnd, band, rowBytes] {
+                auto format = OIIO::TypeDescFromC<F32>::value();
+                return out->write_scanlines(yBegin, yEnd, 0, format, band, OIIO::AutoStride, rowBytes);
+            });
+            progress_ = static_cast<F32>(row) / static_cast<F32>(height);
+        }
+        if (pendingWrite.valid() && !pendingWrite.get()) { return Unexpected(ImageIOError(path, out->geterror())); }
+        if (!out->close()) { return Unexpected(ImageIOError(path, out->geterror())); }
+        progress_ = 1.0f;
+        return success;
+    }
+
+}
@@ -1,7 +1,12 @@
 #include <image/Filters.hpp>
 
+#include <algorithm>
+
 #include <glm/geometric.hpp>
 
+#include <image/ScratchArena.hpp>
+#include <image/ThreadPool.hpp>
+
 namespace image {
 
     template <class T>
@@ -9,24 +14,65 @@ namespace image {
         return std::exp2(evs);
     }
 
+    namespace {
+        // Separable filters' functions, shared by their lattice and curve versions.
+
+        auto exposure(F32 factor) noexcept {
+            return [factor](const ColorRGB<F32> &c) {
+                ColorRGB<F32> linear = sRgbToLinear(c) * factor;
+                return linearToSRgb(linear);
+            };
+        }
+
+        auto contrast(F32 factor) noexcept {
+            return [factor](const ColorRGB<F32> &c) {
+                ColorRGB<F32> grey { 0.5 };
+                return linearToSRgb(mix(factor, grey, sRgbToLinear(c)));
+            };
+        }
+
+        /**
+         * @brief Map nodes through lut, mixing in the result by strength.
+         */
+        void mapNodes(const luts::PreparedLut &lut, F32 strength, ColorRGB<F32> *nodes, std::size_t count) noexcept {
+            // Lattices baked for export can have millions of nodes, so they're mapped a chunk per task.
+            constexpr std::size_t chunkSize = 4096;
+            ThreadPool::shared().parallelForRanges(
+                count,
+                [&](std::size_t first, std::size_t last) {
+                    auto &arena = ScratchArena::local();
+                    ScratchArena::Scope scope(arena);
+                    auto *mapped = arena.alloc<ColorRGB<F32>>(last - first);
+                    lut.map(nodes + first, mapped, last - first);
+                    #pragma omp simd
+                    for (std::size_t i = 0; i < last - first; ++i) {
+                        nodes[first + i] = mix(strength, nodes[first + i], mapped[i]);
+                    }
+                },
+                chunkSize);
+        }
+    }
+
     void ExposureFilterSpec::update() noexcept { exposureFactor = evToScale(exposureEvs); }
 
     void ExposureFilterSpec::apply(luts::Lattice3D &lattice) const noexcept {
-        lattice.accumulate([this](ColorRGB<F32> &c) {
-            ColorRGB<F32> linear = sRgbToLinear(c) * exposureFactor;
-            return linearToSRgb(linear);
-        });
+        lattice.accumulate(exposure(exposureFactor));
+    }
+
+    void ExposureFilterSpec::applyCurves(luts::Lattice1D &curves) const noexcept {
+        curves.accumulate(exposure(exposureFactor));
     }
 
     void LutFilterSpec::update() noexcept {
         if (!lut.data) { lut.load(); }
-        interp.load(*lut.data);
     }
 
     void LutFilterSpec::apply(luts::Lattice3D &lattice) const noexcept {
-        if (lut.data) {
-            lattice.accumulate([this](ColorRGB<F32> &c) { return mix(strength, c, interp.map(c)); });
-        }
+        if (lut.data) { mapNodes(*lut.data, strength, lattice.table.data(), lattice.table.size()); }
+    }
+
+    void LutFilterSpec::applyCurves(luts::Lattice1D &curves) const noexcept {
+        if (lut.data) { mapNodes(*lut.data, strength, curves.table.data(), curves.size); }
     }
 
     void SaturationFilterSpec::apply(luts::Lattice3D &lattice) const noexcept {
@@ -34,10 +80,10 @@ namespace image {
         lattice.accumulate([this, &mat](ColorRGB<F32> &c) { return linearToSRgb(mat * sRgbToLinear(c)); });
     }
 
-    void ContrastFilterSpec::apply(luts::Lattice3D &lattice) const noexcept {
-        ColorRGB<F32> grey { 0.5 };
-        lattice.accumulate(
-            [this, &grey](ColorRGB<F32> &c) { return linearToSRgb(mix(factor, grey, sRgbToLinear(c))); });
+    void ContrastFilterSpec::apply(luts::Lattice3D &lattice) const noexcept { lattice.accumulate(contrast(factor)); }
+
+    void ContrastFilterSpec::applyCurves(luts::Lattice1D &curves) const noexcept {
+        curves.accumulate(contrast(factor));
     }
 
     void ChannelMixerFilterSpec::apply(luts::Lattice3D &lattice) const noexcept {
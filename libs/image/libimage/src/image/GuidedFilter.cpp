@@ -0,0 +1,260 @@
+#include <image/GuidedFilter.hpp>
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <vector>
+
+#include <cmrc/cmrc.hpp>
+#include <glm/glm.hpp>
+
+#include <image/Stopwatch.hpp>
+#include <image/ThreadPool.hpp>
+#include <image/opencl/Manager.hpp>
+
+CMRC_DECLARE(image::rc);
+
+namespace image {
+
+    namespace {
+        /**
+         * @brief How much to reduce the resolution by when finding the filter's coefficients.
+         */
+        memory::Size subsamplingFor(memory::Size radius) noexcept { return std::clamp<memory::Size>(radius / 4, 1, 4); }
+
+        /**
+         * @brief Replace data with the mean over a (2r+1)^2 window clipped to the image.
+         *
+         * Both passes keep a running sum, so the cost per pixel is constant whatever the radius.
+         */
+        template <class T>
+        void boxFilter(std::vector<T> &data,
+                       std::vector<T> &scratch,
+                       memory::Size w,
+                       memory::Size h,
+                       memory::Size r) noexcept {
+            auto &pool = ThreadPool::shared();
+            pool.parallelFor(h, [&](memory::Size y) {
+                const T *in = data.data() + y * w;
+                T *out = scratch.data() + y * w;
+                T sum { 0.0f };
+                for (memory::Size x = 0; x <= std::min(r, w - 1); ++x) { sum += in[x]; }
+                for (memory::Size x = 0; x < w; ++x) {
+                    memory::Size lo = x >= r ? x - r : 0;
+                    memory::Size count = std::min(x + r, w - 1) - lo + 1;
+                    out[x] = sum / static_cast<F32>(count);
+                    if (x + r + 1 < w) { sum += in[x + r + 1]; }
+                    if (x >= r) { sum -= in[x - r]; }
+                }
+            });
+
+            // Columns are done in strips so that each step reads part of a row rather than a single pixel.
+            constexpr memory::Size strip = 64;
+            pool.parallelFor((w + strip - 1) / strip, [&](memory::Size stripIndex) {
+                memory::Size x0 = stripIndex * strip;
+                memory::Size n = std::min(strip, w - x0);
+                std::array<T, strip> sums;
+                std::fill(sums.begin(), sums.end(), T { 0.0f });
+                for (memory::Size y = 0; y <= std::min(r, h - 1); ++y) {
+                    for (memory::Size i = 0; i < n; ++i) { sums[i] += scratch[y * w + x0 + i]; }
+                }
+                for (memory::Size y = 0; y < h; ++y) {
+                    memory::Size lo = y >= r ? y - r : 0;
+                    auto count = static_cast<F32>(std::min(y + r, h - 1) - lo + 1);
+                    for (memory::Size i = 0; i < n; ++i) { data[y * w + x0 + i] = sums[i] / count; }
+                    if (y + r + 1 < h) {
+                        for (memory::Size i = 0; i < n; ++i) { sums[i] += scratch[(y + r + 1) * w + x0 + i]; }
+                    }
+                    if (y >= r) {
+                        for (memory::Size i = 0; i < n; ++i) { sums[i] -= scratch[(y - r) * w + x0 + i]; }
+                    }
+                }
+            }, 1);
+        }
+
+        template <class... Ts>
+        void runKernel(opencl::Kernel &kernel, const Shape &globalWorkShape, Ts &&...args) noexcept {
+            auto saResult = kernel.setArgs(std::forward<Ts>(args)...);
+            if (saResult.hasError()) {
+                std::cerr << "Error setting kernel args: " << saResult.error().error << " (arg #"
+                          << saResult.error().argIdx << ")\n";
+                std::terminate();
+            }
+            auto runResult = kernel.run(opencl::Manager::the()->queue.getHandle(), globalWorkShape);
+            if (runResult.hasError()) {
+                std::cerr << "Error running kernel: " << runResult.error() << "\n";
+                std::terminate();
+            }
+        }
+
+        opencl::Kernel getKernel(opencl::Program &program, const String &name) noexcept {
+            auto maybeKern = program.getKernel(name);
+            if (maybeKern.hasError()) {
+                std::cerr << "Error getting kernel from program\n";
+                std::terminate();
+            }
+            return std::move(*maybeKern);
+        }
+    }
+
+    void guidedFilterHost(const ImageBuf<F32> &img,
+                          Mask &mask,
+                          memory::Size divisor,
+                          memory::Size radius,
+                          F32 epsilon) noexcept {
+        STOPWATCH("Refining mask");
+        Mask guide { mask.size };
+        downsampleLuma(img, guide, divisor);
+
+        memory::Size width = mask.width();
+        memory::Size height = mask.height();
+        memory::Size s = subsamplingFor(radius);
+        memory::Size r = std::max<memory::Size>(radius / s, 1);
+        memory::Size lowWidth = (width + s - 1) / s;
+        memory::Size lowHeight = (height + s - 1) / s;
+
+        // Average guide and mask over each block, then take the local means needed for the linear model.
+        std::vector<glm::vec4> stats(lowWidth * lowHeight);
+        std::vector<glm::vec4> scratch(lowWidth * lowHeight);
+        auto &pool = ThreadPool::shared();
+        pool.parallelFor(lowHeight, [&](memory::Size y) {
+            for (memory::Size x = 0; x < lowWidth; ++x) {
+                F32 i = 0.0f;
+                F32 p = 0.0f;
+                memory::Size n = 0;
+                for (memory::Size yy = y * s; yy < std::min(y * s + s, height); ++yy) {
+                    for (memory::Size xx = x * s; xx < std::min(x * s + s, width); ++xx) {
+                        i += guide.pixelArray.at(xx, yy);
+                        p += mask.pixelArray.at(xx, yy);
+                        ++n;
+                    }
+                }
+                i /= static_cast<F32>(n);
+                p /= static_cast<F32>(n);
+                stats[y * lowWidth + x] = glm::vec4 { i, p, i * i, i * p };
+            }
+        });
+        boxFilter(stats, scratch, lowWidth, lowHeight, r);
+
+        // Fit mask = a * guide + b in each window, then average the coefficients of overlapping windows.
+        std::vector<glm::vec2> coefficients(lowWidth * lowHeight);
+        std::vector<glm::vec2> coefficientScratch(lowWidth * lowHeight);
+        pool.parallelFor(stats.size(), [&](memory::Size idx) {
+            const auto &m = stats[idx];
+            F32 variance = m.z - m.x * m.x;
+            F32 covariance = m.w - m.x * m.y;
+            F32 a = covariance / (variance + epsilon);
+            coefficients[idx] = glm::vec2 { a, m.y - a * m.x };
+        });
+        boxFilter(coefficients, coefficientScratch, lowWidth, lowHeight, r);
+
+        // Upsample the coefficients bilinearly and apply them to the full resolution guide.
+        pool.parallelFor(height, [&](memory::Size y) {
+            F32 fy = std::clamp((static_cast<F32>(y) + 0.5f) / s - 0.5f, 0.0f, static_cast<F32>(lowHeight - 1));
+            auto y0 = static_cast<memory::Size>(fy);
+            auto y1 = std::min(y0 + 1, lowHeight - 1);
+            F32 ty = fy - static_cast<F32>(y0);
+            for (memory::Size x = 0; x < width; ++x) {
+                F32 fx = std::clamp((static_cast<F32>(x) + 0.5f) / s - 0.5f, 0.0f, static_cast<F32>(lowWidth - 1));
+                auto x0 = static_cast<memory::Size>(fx);
+                auto x1 = std::min(x0 + 1, lowWidth - 1);
+                F32 tx = fx - static_cast<F32>(x0);
+                auto top = glm::mix(coefficients[y0 * lowWidth + x0], coefficients[y0 * lowWidth + x1], tx);
+                auto bottom = glm::mix(coefficients[y1 * lowWidth + x0], coefficients[y1 * lowWidth + x1], tx);
+                auto c = glm::mix(top, bottom, ty);
+                mask.pixelArray.at(x, y) = std::clamp(c.x * guide.pixelArray.at(x, y) + c.y, 0.0f, 1.0f);
+            }
+        });
+    }
+
+    void GuidedFilter::apply(const ImageBuf<F32> &img,
+                             Mask &mask,
+                             memory::Size divisor,
+                             memory::Size radius,
+                             F32 epsilon) noexcept {
+        STOPWATCH("Refining mask on device");
+        memory::Size s = subsamplingFor(radius);
+        allocate(mask.size, s);
+
+        std::copy(mask.pixelArray.begin(), mask.pixelArray.end(), deviceMask.pixelArray.begin());
+        deviceMask.pixelArray.buffer()->copyHostToDevice();
+
+        cl_uint imagePitch = img.rowPitch();
+        cl_uint imageWidth = img.width();
+        cl_uint imageHeight = img.height();
+        cl_uint width = maskSize.x;
+        cl_uint resolutionDivisor = divisor;
+        cl_uint height = maskSize.y;
+        cl_uint lowWidth = lowSize.x;
+        cl_uint lowHeight = lowSize.y;
+        cl_uint subsampling = s;
+        cl_uint r = std::max<memory::Size>(radius / s, 1);
+
+        runKernel(oclKernelGuide, Shape { maskSize.x, maskSize.y }, img.pixelArray, imagePitch, imageWidth, imageHeight,
+                  width, resolutionDivisor, guide.pixelArray);
+        runKernel(oclKernelDownsample, Shape { lowSize.x, lowSize.y }, guide.pixelArray, deviceMask.pixelArray, width,
+                  height, subsampling, stats);
+        runKernel(oclKernelBoxRows, Shape { lowSize.y }, stats, scratch, lowWidth, r);
+        runKernel(oclKernelBoxColumns, Shape { lowSize.x }, scratch, stats, lowWidth, lowHeight, r);
+        runKernel(oclKernelCoefficients, Shape { lowSize.x * lowSize.y }, stats, epsilon);
+        runKernel(oclKernelBoxRows, Shape { lowSize.y }, stats, scratch, lowWidth, r);
+        runKernel(oclKernelBoxColumns, Shape { lowSize.x }, scratch, stats, lowWidth, lowHeight, r);
+        runKernel(oclKernelOutput, Shape { maskSize.x, maskSize.y }, guide.pixelArray, stats, width, lowWidth,
+                  lowHeight, subsampling, deviceMask.pixelArray);
+
+        deviceMask.pixelArray.buffer()->copyDeviceToHost();
+        std::copy(deviceMask.pixelArray.begin(), deviceMask.pixelArray.end(), mask.pixelArray.begin());
+    }
+
+    void GuidedFilter::allocate(const ImageSize &size, memory::Size subsampling) noexcept {
+        ImageSize low { (size.x + subsampling - 1) / subsampling, (size.y + subsampling - 1) / subsampling };
+        auto device = opencl::Manager::the()->bufferDevice;
+        if (maskSize != size) {
+            maskSize = size;
+            deviceMask = Mask { size };
+            deviceMask.pixelArray.buffer()->setDevice(device);
+            deviceMask.pixelArray.buffer()->deviceMalloc();
+            guide = Mask { size };
+            guide.pixelArray.buffer()->setDevice(device);
+            guide.pixelArray.buffer()->deviceMalloc();
+        }
+        if (lowSize != low) {
+            lowSize = low;
+            stats = NDArray<F32> { Shape { 4, low.x, low.y } };
+            stats.buffer()->setDevice(device);
+            stats.buffer()->deviceMalloc();
+            scratch = NDArray<F32> { Shape { 4, low.x, low.y } };
+            scratch.buffer()->setDevice(device);
+            scratch.buffer()->deviceMalloc();
+        }
+    }
+
+    GuidedFilter::GuidedFilter() noexcept {
+        {
+            auto fs = cmrc::image::rc::get_filesystem();
+            auto f = fs.open("kernels/guidedFilter.cl");
+            String src { f.begin(), f.end() };
+
+            auto maybeProg = opencl::Program::fromSource(opencl::Manager::the()->context, src);
+            if (maybeProg.hasError()) {
+                std::cerr << "Error loading program\n";
+                std::terminate();
+            }
+            oclProgram = std::move(*maybeProg);
+        }
+        {
+            auto buildResult = oclProgram.build();
+            if (buildResult.hasError()) {
+                std::cerr << "Error building program\n";
+                std::terminate();
+            }
+        }
+        oclKernelGuide = getKernel(oclProgram, "guidedFilter_guide_F32");
+        oclKernelDownsample = getKernel(oclProgram, "guidedFilter_downsample_F32");
+        oclKernelBoxRows = getKernel(oclProgram, "boxFilterRows_F32x4");
+        oclKernelBoxColumns = getKernel(oclProgram, "boxFilterColumns_F32x4");
+        oclKernelCoefficients = getKernel(oclProgram, "guidedFilter_coefficients_F32");
+        oclKernelOutput = getKernel(oclProgram, "guidedFilter_output_F32");
+    }
+
+}
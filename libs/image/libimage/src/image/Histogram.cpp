@@ -0,0 +1,33 @@
+#include <image/Histogram.hpp>
+
+#include <image/CpuDispatch.hpp>
+
+namespace image::detail {
+
+    IMAGE_CPU_DISPATCH
+    void bucketIndices(const F32 *pixels,
+                       memory::Size count,
+                       memory::Size stride,
+                       memory::Size numBuckets,
+                       U32 *indices) noexcept {
+        auto scale = static_cast<F32>(numBuckets);
+        auto last = static_cast<F32>(numBuckets - 1);
+        auto bucket = [scale, last](F32 value) { return static_cast<U32>(std::clamp(value * scale, 0.0f, last)); };
+        auto n = static_cast<U32>(numBuckets);
+        if (stride == 1) {
+            #pragma omp simd
+            for (memory::Size i = 0; i < 3 * count; ++i) {
+                indices[i] = static_cast<U32>(i % 3) * n + bucket(pixels[i]);
+            }
+        } else {
+            #pragma omp simd
+            for (memory::Size i = 0; i < count; ++i) {
+                const F32 *pixel = pixels + i * stride * 3;
+                indices[3 * i] = bucket(pixel[0]);
+                indices[3 * i + 1] = n + bucket(pixel[1]);
+                indices[3 * i + 2] = 2 * n + bucket(pixel[2]);
+            }
+        }
+    }
+
+}
@@ -0,0 +1,68 @@
+#include <image/LutExport.hpp>
+
+#include <algorithm>
+#include <cctype>
+
+#include <image/Serialization.hpp>
+#include <image/Stopwatch.hpp>
+#include <image/luts/CubeFile.hpp>
+#include <image/luts/Hald.hpp>
+
+namespace image {
+
+    luts::Lattice3D bakeComposition(const Composition &composition, std::size_t size) noexcept {
+        STOPWATCH("Baking composition");
+        // The same walk as OpSequenceBuilder, but into a single host lattice at the export size. Each filter
+        // accumulates over the lattice's nodes in parallel.
+        luts::Lattice3D lattice(size);
+        lattice.loadIdentity();
+        for (const auto &layer : composition.layers) {
+            if (!layer->isEnabled || layer->hasActiveMask()) { continue; }
+            for (const auto &filter : layer->filters->filterSpecs) {
+                if (filter->isEnabled) { filter->apply(lattice); }
+            }
+        }
+        return lattice;
+    }
+
+    Expected<void, LutExportError> exportLut(const Composition &composition,
+                                             const Path &path,
+                                             std::size_t size) noexcept {
+        STOPWATCH("Exporting LUT");
+        auto ext = path.extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+        if (ext == ".cube") {
+            auto result = luts::CubeFile(bakeComposition(composition, size)).save(path);
+            if (result.hasError()) { return Unexpected(LutExportError { path, result.error().reason }); }
+            return success;
+        }
+
+        std::size_t level = 2;
+        while (level * level < size) { ++level; }
+        auto result = writeHaldToFile(path, bakeComposition(composition, level * level));
+        if (result.hasError()) { return Unexpected(LutExportError { path, result.error().reason }); }
+        return success;
+    }
+
+    LutExportJob::LutExportJob(const Composition &comp,
+                               const Path &path,
+                               std::size_t size,
+                               FinishedCallback onFinished) noexcept
+      // Baking only reads the layers and filters, but they're copied for the same reason as in ExportJob: interactive
+      // edits mustn't touch what the job is reading.
+      : composition(std::make_shared<Composition>(serialization::copyComposition(comp)))
+      , path(path)
+      , size(size)
+      , onFinished(std::move(onFinished)) {
+        thread = std::thread([this] {
+            auto result = exportLut(*composition, this->path, this->size);
+            isFinished_ = true;
+            if (this->onFinished) { this->onFinished(result); }
+        });
+    }
+
+    LutExportJob::~LutExportJob() noexcept {
+        if (thread.joinable()) { thread.join(); }
+    }
+
+}
@@ -0,0 +1,102 @@
+#include <image/MappedFile.hpp>
+
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace image {
+
+#ifdef _WIN32
+    Expected<MappedFile, MappedFileError> MappedFile::open(const Path &path) noexcept {
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                  FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) { return Unexpected(MappedFileError { path, "Failed to open file" }); }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size)) {
+            CloseHandle(file);
+            return Unexpected(MappedFileError { path, "Failed to get file size" });
+        }
+
+        MappedFile mapped;
+        mapped.size_ = static_cast<std::size_t>(size.QuadPart);
+        // Mapping zero bytes fails, but an empty file is still a valid (empty) mapping.
+        if (mapped.size_ > 0) {
+            HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            void *data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+            // The view stays valid after both handles are closed.
+            if (mapping) { CloseHandle(mapping); }
+            if (!data) {
+                CloseHandle(file);
+                return Unexpected(MappedFileError { path, "Failed to map file" });
+            }
+            mapped.data_ = static_cast<const char *>(data);
+        }
+        CloseHandle(file);
+        return mapped;
+    }
+
+    void MappedFile::unmap() noexcept {
+        if (data_) { UnmapViewOfFile(data_); }
+    }
+#else
+    Expected<MappedFile, MappedFileError> MappedFile::open(const Path &path) noexcept {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) { return Unexpected(MappedFileError { path, std::strerror(errno) }); }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            auto reason = std::strerror(errno);
+            close(fd);
+            return Unexpected(MappedFileError { path, reason });
+        }
+
+        MappedFile mapped;
+        mapped.size_ = static_cast<std::size_t>(st.st_size);
+        // Mapping zero bytes fails, but an empty file is still a valid (empty) mapping.
+        if (mapped.size_ > 0) {
+            void *data = mmap(nullptr, mapped.size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                auto reason = std::strerror(errno);
+                close(fd);
+                return Unexpected(MappedFileError { path, reason });
+            }
+            // The whole file is about to be read front to back.
+            madvise(data, mapped.size_, MADV_SEQUENTIAL);
+            mapped.data_ = static_cast<const char *>(data);
+        }
+        // The mapping stays valid after the descriptor is closed.
+        close(fd);
+        return mapped;
+    }
+
+    void MappedFile::unmap() noexcept {
+        if (data_) { munmap(const_cast<char *>(data_), size_); }
+    }
+#endif
+
+    MappedFile::MappedFile(MappedFile &&other) noexcept
+      : data_(std::exchange(other.data_, nullptr))
+      , size_(std::exchange(other.size_, 0)) {}
+
+    MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+        if (this != &other) {
+            unmap();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+        }
+        return *this;
+    }
+
+    MappedFile::~MappedFile() noexcept { unmap(); }
+
+}
@@ -1,9 +1,17 @@
 #include <image/Mask.hpp>
 
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cmath>
+#include <limits>
+#include <set>
 
+#include <image/CpuDispatch.hpp>
 #include <image/IO.hpp>
 #include <image/Stopwatch.hpp>
+#include <image/ThreadPool.hpp>
+#include <image/TiledMask.hpp>
 #include <image/opencl/Manager.hpp>
 
 namespace image {
@@ -38,33 +46,247 @@ namespace image {
         }
     };
 
+    /**
+     * @brief The span of a single row over which a linear gradient isn't constant, plus its values either side.
+     */
+    struct LinearGradientRowSpan {
+        F64 lo;
+        F64 hi;
+        F32 left;
+        F32 right;
+
+        LinearGradientRowSpan(const glm::vec4 &params, F64 y, const ImageSize &size) noexcept {
+            auto [a, b, c1, c2] = std::array<F64, 4> { params.x, params.y, params.z, params.w };
+            F64 offset = b * y / static_cast<F64>(size.y);
+            if (a == 0.0) {
+                // Constant across the whole row.
+                F32 value = offset <= c1 ? 0.0f : offset >= c2 ? 1.0f : static_cast<F32>((offset - c1) / (c2 - c1));
+                lo = std::numeric_limits<F64>::infinity();
+                hi = -std::numeric_limits<F64>::infinity();
+                left = value;
+                right = value;
+                return;
+            }
+            F64 scale = static_cast<F64>(size.x) / a;
+            lo = std::min((c1 - offset) * scale, (c2 - offset) * scale);
+            hi = std::max((c1 - offset) * scale, (c2 - offset) * scale);
+            left = a > 0 ? 0.0f : 1.0f;
+            right = a > 0 ? 1.0f : 0.0f;
+        }
+    };
+
+    std::vector<MaskRegion> changedRegions(const ProceduralMask &prev,
+                                           const ProceduralMask &next,
+                                           const ImageSize &size) noexcept {
+        if (prev.kind != next.kind || prev.kind != ProceduralMaskKind::LinearGradient) {
+            return { MaskRegion { 0, 0, size.x, size.y } };
+        }
+        if (prev.params == next.params) { return {}; }
+
+        // Rows are grouped into strips so that the number of separate uploads stays small.
+        constexpr memory::Size stripHeight = 32;
+        std::vector<MaskRegion> regions;
+        for (memory::Size stripY = 0; stripY < size.y; stripY += stripHeight) {
+            memory::Size stripEnd = std::min(stripY + stripHeight, size.y);
+            memory::Size minX = size.x;
+            memory::Size maxX = 0;
+            for (memory::Size y = stripY; y < stripEnd; ++y) {
+                LinearGradientRowSpan p { prev.params, static_cast<F64>(y), size };
+                LinearGradientRowSpan n { next.params, static_cast<F64>(y), size };
+                // Outside both transition zones both gradients are constant, so only the zones themselves and any
+                // side where the constants disagree can have changed.
+                F64 lo = p.left != n.left ? 0.0 : std::min(p.lo, n.lo);
+                F64 hi = p.right != n.right ? static_cast<F64>(size.x) : std::max(p.hi, n.hi);
+                if (lo > hi) { continue; }
+                // Pad by a pixel to stay conservative against rounding in the float evaluation.
+                auto x0 = static_cast<memory::Size>(std::clamp(std::floor(lo) - 1.0, 0.0, static_cast<F64>(size.x)));
+                auto x1 = static_cast<memory::Size>(std::clamp(std::ceil(hi) + 2.0, 0.0, static_cast<F64>(size.x)));
+                if (x0 >= x1) { continue; }
+                minX = std::min(minX, x0);
+                maxX = std::max(maxX, x1);
+            }
+            if (minX < maxX) { regions.push_back(MaskRegion { minX, stripY, maxX - minX, stripEnd - stripY }); }
+        }
+        return regions;
+    }
+
+    IMAGE_CPU_DISPATCH
+    static void generateLinearGradientRow(const LinearGradientProjection &proj,
+                                          Mask &mask,
+                                          const MaskRegion &region,
+                                          memory::Size y) noexcept {
+        glm::vec2 size { static_cast<F32>(mask.width()), static_cast<F32>(mask.height()) };
+        for (memory::Size x = region.x; x < region.x + region.width; ++x) {
+            glm::vec2 pos = glm::vec2 { static_cast<F32>(x), static_cast<F32>(y) } / size;
+            auto value = proj.map(pos);
+            mask.pixelArray.at(x, y) = value;
+        }
+    }
+
+    static void generateLinearGradient(const LinearGradientProjection &proj,
+                                       Mask &mask,
+                                       const MaskRegion &region) noexcept {
+        ThreadPool::shared().parallelFor(region.height, [&](memory::Size row) {
+            generateLinearGradientRow(proj, mask, region, region.y + row);
+        });
+    }
+
     void LinearGradientMaskSpec::generate(Mask &mask) const noexcept {
         // STOPWATCH("Generating linear gradient mask");
+        generateLinearGradient({ from, to }, mask, MaskRegion { 0, 0, mask.width(), mask.height() });
+    }
+
+    void LinearGradientMaskSpec::generateRegion(const ImageBuf<F32> &,
+                                                Mask &mask,
+                                                const MaskRegion &region) const noexcept {
+        generateLinearGradient({ from, to }, mask, region);
+    }
+
+    std::optional<ProceduralMask> LinearGradientMaskSpec::procedural() const noexcept {
         LinearGradientProjection proj { from, to };
-        glm::vec2 size { static_cast<F32>(mask.width()), static_cast<F32>(mask.height()) };
-        #pragma omp parallel for
-        for (memory::Size y = 0; y < mask.height(); ++y) {
-            #pragma omp parallel for
-            for (memory::Size x = 0; x < mask.width(); ++x) {
-                glm::vec2 pos = glm::vec2 { static_cast<F32>(x), static_cast<F32>(y) } / size;
-                auto value = proj.map(pos);
-                mask.pixelArray.at(x, y) = value;
-            }
+        return ProceduralMask { ProceduralMaskKind::LinearGradient, glm::vec4 { proj.a, proj.b, proj.c1, proj.c2 } };
+    }
+
+    IMAGE_CPU_DISPATCH
+    static void downsampleLumaRow(const ImageBuf<F32> &img, Mask &mask, memory::Size divisor, memory::Size y) noexcept {
+        auto luma = [&img](memory::Size px, memory::Size py) {
+            const auto &color = img.at(px, py);
+            return (color.r + color.g + color.b) / 3.0f;
+        };
+        memory::Size y0 = std::min(y * divisor + (divisor - 1) / 2, img.height() - 1);
+        memory::Size y1 = std::min(y * divisor + divisor / 2, img.height() - 1);
+        for (memory::Size x = 0; x < mask.width(); ++x) {
+            memory::Size x0 = std::min(x * divisor + (divisor - 1) / 2, img.width() - 1);
+            memory::Size x1 = std::min(x * divisor + divisor / 2, img.width() - 1);
+            auto value = (luma(x0, y0) + luma(x1, y0) + luma(x0, y1) + luma(x1, y1)) * 0.25f;
+            mask.pixelArray.at(x, y) = value;
         }
     }
 
+    void downsampleLuma(const ImageBuf<F32> &img, Mask &mask, memory::Size divisor) noexcept {
+        // Each mask pixel covers a block of image pixels. Average the 2x2 pixels at the block's centre, which is
+        // enough of a pre-filter for a mask that's blurred by upsampling anyway.
+        ThreadPool::shared().parallelFor(mask.height(),
+                                         [&](memory::Size y) { downsampleLumaRow(img, mask, divisor, y); });
+    }
+
     void LumaMaskGenerator::generate(const ImageBuf<F32> &img, Mask &mask) const noexcept {
         STOPWATCH("Generating luma mask");
-        glm::vec2 size { static_cast<F32>(mask.width()), static_cast<F32>(mask.height()) };
-        #pragma omp parallel for
-        for (memory::Size y = 0; y < mask.height(); ++y) {
-            #pragma omp parallel for
-            for (memory::Size x = 0; x < mask.width(); ++x) {
-                const auto &color = img.at(x, y);
-                auto value = (color.r + color.g + color.b) / 3.0f;
-                mask.pixelArray.at(x, y) = value;
+        downsampleLuma(img, mask, resolutionDivisor());
+    }
+
+    namespace {
+        F32 distanceToSegment(const glm::vec2 &p, const glm::vec2 &a, const glm::vec2 &b) noexcept {
+            auto ab = b - a;
+            auto len2 = glm::dot(ab, ab);
+            auto t = len2 > 0.0f ? std::clamp(glm::dot(p - a, ab) / len2, 0.0f, 1.0f) : 0.0f;
+            return glm::length(p - (a + ab * t));
+        }
+
+        /**
+         * @brief Paint the segments of a stroke from firstSegment onwards into the tiles.
+         *
+         * Strokes are composited with max (or min when erasing), so repainting a segment has no further effect.
+         */
+        void rasterizeStroke(const BrushStroke &stroke, memory::Size firstSegment, TiledMask &tiles) noexcept {
+            if (stroke.points.empty()) { return; }
+            constexpr auto tileSize = TiledMask::tileSize;
+            glm::vec2 size { static_cast<F32>(tiles.size.x), static_cast<F32>(tiles.size.y) };
+            F32 radius = stroke.radius * size.x;
+            F32 inner = radius * std::clamp(stroke.hardness, 0.0f, 1.0f);
+            I32 coveredState = stroke.erase ? TiledMask::emptyTile : TiledMask::fullTile;
+            // A single point is painted as a zero-length segment.
+            memory::Size numSegments = std::max<memory::Size>(stroke.points.size(), 2) - 1;
+
+            std::set<std::pair<memory::Size, memory::Size>> touched;
+            for (memory::Size i = firstSegment; i < numSegments; ++i) {
+                auto a = stroke.points[i] * size;
+                auto b = stroke.points[std::min(i + 1, stroke.points.size() - 1)] * size;
+
+                auto lo = glm::clamp(glm::min(a, b) - radius, 0.0f, std::max(size.x, size.y));
+                auto hi = glm::max(a, b) + radius;
+                auto tx0 = static_cast<memory::Size>(lo.x) / tileSize;
+                auto ty0 = static_cast<memory::Size>(lo.y) / tileSize;
+                auto tx1 = std::min(static_cast<memory::Size>(std::max(hi.x, 0.0f)) / tileSize + 1, tiles.tilesX);
+                auto ty1 = std::min(static_cast<memory::Size>(std::max(hi.y, 0.0f)) / tileSize + 1, tiles.tilesY);
+
+                // Classify tiles first. Distance to a segment is convex, so it's largest at one of the tile's corners.
+                std::vector<std::pair<memory::Size, memory::Size>> partial;
+                for (auto ty = ty0; ty < ty1; ++ty) {
+                    for (auto tx = tx0; tx < tx1; ++tx) {
+                        glm::vec2 tileLo { static_cast<F32>(tx * tileSize), static_cast<F32>(ty * tileSize) };
+                        glm::vec2 tileHi = glm::min(tileLo + static_cast<F32>(tileSize - 1), size - 1.0f);
+                        auto centre = (tileLo + tileHi) * 0.5f;
+                        if (distanceToSegment(centre, a, b) - glm::length(tileHi - centre) >= radius) { continue; }
+                        auto farthest = std::max({ distanceToSegment(tileLo, a, b),
+                                                   distanceToSegment(tileHi, a, b),
+                                                   distanceToSegment({ tileLo.x, tileHi.y }, a, b),
+                                                   distanceToSegment({ tileHi.x, tileLo.y }, a, b) });
+                        if (farthest <= inner) {
+                            tiles.fillTile(tx, ty, coveredState);
+                        } else if (tiles.tile(tx, ty) != coveredState) {
+                            partial.emplace_back(tx, ty);
+                        }
+                    }
+                }
+
+                // Allocating slots may reallocate the pool, so do it all before painting in parallel.
+                for (auto &&[tx, ty] : partial) {
+                    tiles.editTile(tx, ty);
+                    touched.emplace(tx, ty);
+                }
+
+                // A tile per task: a whole tile is plenty of work, and there are often only a few.
+                ThreadPool::shared().parallelFor(partial.size(), [&](memory::Size t) {
+                    auto [tx, ty] = partial[t];
+                    auto data = tiles.slotData(tiles.tile(tx, ty));
+                    memory::Size w = std::min(tileSize, tiles.size.x - tx * tileSize);
+                    memory::Size h = std::min(tileSize, tiles.size.y - ty * tileSize);
+                    for (memory::Size y = 0; y < h; ++y) {
+                        for (memory::Size x = 0; x < w; ++x) {
+                            glm::vec2 pos { static_cast<F32>(tx * tileSize + x), static_cast<F32>(ty * tileSize + y) };
+                            auto d = distanceToSegment(pos, a, b);
+                            if (d >= radius) { continue; }
+                            F32 value = 1.0f;
+                            if (d > inner) {
+                                auto f = (radius - d) / (radius - inner);
+                                value = f * f * (3.0f - 2.0f * f);
+                            }
+                            // Tiles hold linear values. pow() is monotonic so min/max give the same result.
+                            auto &px = data[y * tileSize + x];
+                            px = stroke.erase ? std::min(px, std::pow(1.0f - value, maskGamma))
+                                              : std::max(px, std::pow(value, maskGamma));
+                        }
+                    }
+                }, 1);
             }
+
+            for (auto &&[tx, ty] : touched) { tiles.compactTile(tx, ty); }
+        }
+    }
+
+    void BrushMaskGenerator::generate(const ImageBuf<F32> &, Mask &mask) const noexcept {
+        STOPWATCH("Generating brush mask");
+        TiledMask tiles { mask.size };
+        generateTiled(tiles);
+        tiles.toDense(mask);
+    }
+
+    void BrushMaskGenerator::generateTiled(TiledMask &tiles) const noexcept {
+        if (tiles.sourceEpoch != epoch || tiles.sourceCount > strokes.size()) {
+            tiles.clear();
+            tiles.sourceEpoch = epoch;
+        }
+        if (strokes.empty()) { return; }
+        if (tiles.sourceCount == strokes.size() && tiles.sourceSubCount == strokes.back().points.size()) { return; }
+        // The last stroke seen may have had points added since, so continue it from its last painted segment.
+        auto first = tiles.sourceCount > 0 ? tiles.sourceCount - 1 : 0;
+        for (auto i = first; i < strokes.size(); ++i) {
+            auto firstSegment = i == first && tiles.sourceSubCount > 0 ? tiles.sourceSubCount - 1 : 0;
+            rasterizeStroke(strokes[i], firstSegment, tiles);
         }
+        tiles.sourceCount = strokes.size();
+        tiles.sourceSubCount = strokes.back().points.size();
     }
 
 }
@@ -1,5 +1,6 @@
 #include <image/MaskProcessor.hpp>
 
+#include <algorithm>
 #include <iostream>
 
 #include <cmrc/cmrc.hpp>
@@ -18,8 +19,18 @@ namespace image {
     }
 
     void MaskProcessor::generateOverlayImage(const Mask &mask, ImageBuf<U8, RGBA> &out) noexcept {
+        // Upload mask.
+        if (deviceMask.size != mask.size) {
+            deviceMask = Mask { mask.size };
+            deviceMask.pixelArray.buffer()->setDevice(opencl::Manager::the()->bufferDevice);
+            deviceMask.pixelArray.buffer()->deviceMalloc();
+        }
+        std::copy(mask.pixelArray.begin(), mask.pixelArray.end(), deviceMask.pixelArray.begin());
+        deviceMask.pixelArray.buffer()->copyHostToDevice();
+
         // Set args.
-        auto saResult = oclKernelGenerateOverlayImage.setArgs(mask.pixelArray, out.pixelArray);
+        cl_uint outputPitch = out.rowPitchBytes();
+        auto saResult = oclKernelGenerateOverlayImage.setArgs(deviceMask.pixelArray, out.pixelArray, outputPitch);
         if (saResult.hasError()) {
             std::cerr << "Error setting kernel args: " << saResult.error().error << " (arg #" << saResult.error().argIdx
                       << ")\n";
@@ -28,7 +39,7 @@ namespace image {
 
         // Run the kernel.
         auto runResult = oclKernelGenerateOverlayImage.run(opencl::Manager::the()->queue.getHandle(),
-                                                           Shape { mask.width() * mask.height() });
+                                                           Shape { mask.width(), mask.height() });
         if (runResult.hasError()) {
             std::cerr << "Error running kernel: " << runResult.error() << "\n";
             std::terminate();
@@ -0,0 +1,74 @@
+#include <image/PackedMask.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/gtc/packing.hpp>
+
+#include <image/ThreadPool.hpp>
+#include <image/opencl/BufferDevice.hpp>
+#include <image/opencl/Manager.hpp>
+
+namespace image {
+
+    PackedMask::PackedMask(MaskFormat format,
+                           const ImageSize &size,
+                           std::shared_ptr<memory::AbstractDevice> device) noexcept
+      : format(format)
+      , size(size)
+      , data(Shape { size.x * size.y * bytesPerPixel(format) }) {
+        data.buffer()->setDevice(device);
+        data.buffer()->deviceMalloc();
+    }
+
+    std::shared_ptr<memory::AbstractDevice> PackedMask::makeImageDevice(MaskFormat format,
+                                                                        const ImageSize &size) noexcept {
+        cl_image_format imageFormat { CL_R, CL_FLOAT };
+        switch (format) {
+        case MaskFormat::F32:
+            imageFormat.image_channel_data_type = CL_FLOAT;
+            break;
+        case MaskFormat::F16:
+            imageFormat.image_channel_data_type = CL_HALF_FLOAT;
+            break;
+        case MaskFormat::U8:
+            imageFormat.image_channel_data_type = CL_UNORM_INT8;
+            break;
+        }
+        Shape imageShape { size.x, size.y };
+        return std::make_shared<memory::OpenCLImageDevice>(opencl::Manager::the()->context.getHandle(),
+                                                           opencl::Manager::the()->queue.getHandle(),
+                                                           imageShape.dims(),
+                                                           imageFormat);
+    }
+
+    void PackedMask::pack(const Mask &mask) noexcept { pack(mask, MaskRegion { 0, 0, size.x, size.y }); }
+
+    void PackedMask::pack(const Mask &mask, const MaskRegion &region) noexcept {
+        assert(mask.size == size);
+        auto bpp = bytesPerPixel(format);
+        ThreadPool::shared().parallelFor(region.height, [&](memory::Size row) {
+            memory::Size y = region.y + row;
+            auto out = data.data() + (y * size.x + region.x) * bpp;
+            for (memory::Size x = region.x; x < region.x + region.width; ++x, out += bpp) {
+                // Luma masks of HDR images can leave [0, 1], which would wrap U8 and make pow() NaN.
+                F32 value = std::pow(std::clamp(mask.pixelArray.at(x, y), 0.0f, 1.0f), maskGamma);
+                switch (format) {
+                case MaskFormat::F32:
+                    *reinterpret_cast<F32 *>(out) = value;
+                    break;
+                case MaskFormat::F16:
+                    *reinterpret_cast<U16 *>(out) = glm::packHalf1x16(value);
+                    break;
+                case MaskFormat::U8:
+                    *out = static_cast<U8>(std::lround(value * 255.0f));
+                    break;
+                }
+            }
+        });
+        auto rowPitch = size.x * bpp;
+        data.buffer()->copyHostToDevice(
+            memory::BufferRect { region.x * bpp, region.y, region.width * bpp, region.height, rowPitch });
+    }
+
+}
@@ -1,18 +1,59 @@
 #include <image/Processor.hpp>
 
 #include <algorithm>
+#include <array>
+#include <charconv>
 #include <cassert>
+#include <cmath>
 #include <iostream>
 
 #include <cmrc/cmrc.hpp>
 
 #include <image/Mask.hpp>
+#include <image/TiledExecutor.hpp>
 #include <image/opencl/Manager.hpp>
 
 CMRC_DECLARE(image::rc);
 
 namespace image {
 
+    namespace {
+        /// The histogram is counted by a fixed number of work-groups, so only this many partial histograms are summed.
+        constexpr memory::Size histogramGroups = 256;
+        /// Preferred work-items per group; the kernel strides over its bins by the local size, so fewer also work.
+        constexpr memory::Size maxHistogramGroupSize = 256;
+
+        /// Build options for kernels.cl: defines, plus the host's constants the kernels must agree with.
+        String kernelOptions(const String &defines) noexcept {
+            // Scientific notation with an f suffix is a float literal for any value, exactly the host's.
+            std::array<char, 32> gamma;
+            char *begin = gamma.data();
+            auto [end, ec] = std::to_chars(begin, begin + gamma.size(), maskGamma, std::chars_format::scientific);
+            return defines + " -DMASK_GAMMA=" + String(begin, end) + "f";
+        }
+
+        opencl::Kernel getKernel(opencl::Program &program, const String &name) noexcept {
+            auto maybeKern = program.getKernel(name);
+            if (maybeKern.hasError()) {
+                std::cerr << "Error getting kernel from program\n";
+                std::terminate();
+            }
+            return std::move(*maybeKern);
+        }
+
+        ApplyLutKernels getApplyLutKernels(opencl::Program &program) noexcept {
+            return ApplyLutKernels {
+                getKernel(program, "apply3DLut_F32_F32"),
+                getKernel(program, "apply3DLut_masked_F32_F32"),
+                getKernel(program, "apply3DLut_maskedF16_F32_F32"),
+                getKernel(program, "apply3DLut_maskedU8_F32_F32"),
+                getKernel(program, "apply3DLut_maskedImage_F32_F32"),
+                getKernel(program, "apply3DLut_procedural_F32_F32"),
+                getKernel(program, "apply3DLut_tiled_F32_F32"),
+            };
+        }
+    }
+
     template <class T>
     struct PoolTraits<ImageBuf<T>> {
         static inline ImageBuf<T> construct(memory::Size width, memory::Size height) noexcept {
@@ -49,23 +90,65 @@ namespace image {
             }
         }
         latticeImage.buffer()->copyHostToDevice();
+        interpolator.load(lattice);
+    }
+
+    void Lut::syncCurves() noexcept {
+        for (std::size_t i = 0; i < curves.size; ++i) {
+            const auto &color = curves.table.at(i);
+            curvesBuffer.at(i, 0) = color.r;
+            curvesBuffer.at(i, 1) = color.g;
+            curvesBuffer.at(i, 2) = color.b;
+        }
+        curvesBuffer.buffer()->copyHostToDevice();
     }
 
-    void Lut::reset() noexcept { lattice.loadIdentity(); }
+    void Lut::reset() noexcept {
+        lattice.loadIdentity();
+        curves.loadIdentity();
+    }
 
-    Lut::Lut() noexcept {
+    Lut::Lut(LutStorage storage) noexcept {
         lattice.loadIdentity();
         auto latticeSize = lattice.size;
         Shape shape { 4, latticeSize, latticeSize, latticeSize };
-        Shape imageShape { latticeSize, latticeSize, latticeSize };
-        auto latticeImageDevice = std::make_shared<memory::OpenCLImageDevice>(
-            opencl::Manager::the()->context.getHandle(), opencl::Manager::the()->queue.getHandle(), imageShape.dims());
         latticeImage = NDArray<F32>(shape);
-        latticeImage.buffer()->device = latticeImageDevice;
+        if (storage == LutStorage::Image) {
+            Shape imageShape { latticeSize, latticeSize, latticeSize };
+            latticeImage.buffer()->device =
+                std::make_shared<memory::OpenCLImageDevice>(opencl::Manager::the()->context.getHandle(),
+                                                            opencl::Manager::the()->queue.getHandle(),
+                                                            imageShape.dims());
+        } else {
+            // The same RGBA layout as the image, so the kernels can read nodes as float4.
+            latticeImage.buffer()->device = opencl::Manager::the()->bufferDevice;
+        }
         latticeImage.buffer()->deviceMalloc();
+
+        curves.loadIdentity();
+        curvesBuffer = NDArray<F32>(Shape { curves.size, 3 });
+        curvesBuffer.buffer()->device = opencl::Manager::the()->bufferDevice;
+        curvesBuffer.buffer()->deviceMalloc();
+    }
+
+    LutStorage defaultLutStorage() noexcept {
+        const auto &device = opencl::Manager::the()->context.getDevice();
+        bool isCpu = static_cast<cl_device_type>(device.type) & CL_DEVICE_TYPE_CPU;
+        return isCpu ? LutStorage::Buffer : LutStorage::Image;
+    }
+
+    bool defaultTiledOnHost() noexcept {
+        const auto &device = opencl::Manager::the()->context.getDevice();
+        return static_cast<cl_device_type>(device.type) & CL_DEVICE_TYPE_CPU;
     }
 
-    void OpSequenceBuilder::finaliseOp() noexcept { currentOp.lut->sync(); }
+    void OpSequenceBuilder::finaliseOp() noexcept {
+        if (currentOp.kind == OpKind::Curves) {
+            currentOp.lut->syncCurves();
+        } else {
+            currentOp.lut->sync();
+        }
+    }
 
     void OpSequenceBuilder::newOp() noexcept {
         // Optimisation: if the current op is new (i.e. effectively a no-op) any mask can be discarded and we can just
@@ -77,17 +160,28 @@ namespace image {
         finaliseOp();
         seq.ops.emplace_back(std::exchange(currentOp, Op { lutPool.acquire() }));
         currentOp.lut->lattice.loadIdentity();
+        currentOp.lut->curves.loadIdentity();
         currentIsNew = true;
     }
 
     void OpSequenceBuilder::accumulate(AbstractFilterSpec &filter) noexcept {
         currentIsNew = false;
-        filter.apply(currentOp.lut->lattice);
+        auto &lut = *currentOp.lut;
+        if (currentOp.kind == OpKind::Curves) {
+            if (filter.isSeparable()) {
+                filter.applyCurves(lut.curves);
+                return;
+            }
+            // The op can't be applied a channel at a time any more, so carry on in 3D from what the curves do.
+            lut.lattice.fromFunction([&curves = lut.curves](const ColorRGB<F32> &color) { return curves.map(color); });
+            currentOp.kind = OpKind::Lattice;
+        }
+        filter.apply(lut.lattice);
     }
 
     void OpSequenceBuilder::accumulate(Layer &layer) noexcept {
         if (!layer.isEnabled) { return; }
-        bool hasActiveMask = layer.maskGen && layer.maskGen->isEnabled;
+        bool hasActiveMask = layer.hasActiveMask();
         if (currentOp.maskGen || hasActiveMask) {
             // We need a new op if:
             // - the current op has one already
@@ -120,20 +214,47 @@ namespace image {
 
     void CompositionState::setInput(const ImageBuf<F32> &image) noexcept {
         input = image;
-        input.pixelArray.buffer()->device = opencl::Manager::the()->bufferDevice;
-        input.pixelArray.buffer()->deviceMalloc();
-        input.pixelArray.buffer()->copyHostToDevice();
+        // Images are often uploaded while they're decoded, in which case there's nothing left to do.
+        if (!input.pixelArray.buffer()->device) {
+            input.pixelArray.buffer()->setDevice(opencl::Manager::the()->bufferDevice);
+            input.pixelArray.buffer()->deviceMalloc();
+            input.pixelArray.buffer()->copyHostToDevice();
+        }
 
         // Invalidate all the state.
         intermediateImagePool = std::make_unique<Pool<ImageBuf<F32>, 3>>(input.width(), input.height());
         generatedMasks.clear();
+        packedMasks.clear();
+        staleMasks.clear();
+        generatedParams.clear();
+        tiledMasks.clear();
     }
 
     Mask &CompositionState::update(AbstractMaskGenerator *maskGen) noexcept {
         if (auto it = generatedMasks.find(maskGen); it != generatedMasks.end()) {
             auto &maskBuf = it->second;
-            maskGen->generate(input, maskBuf);
-            maskBuf.pixelArray.buffer()->copyHostToDevice();
+            auto packedIt = packedMasks.find(maskGen);
+            // Refinement looks at the whole neighbourhood, so refined masks are always regenerated in full.
+            auto procedural = maskGen->isRefined() ? std::nullopt : maskGen->procedural();
+            auto prevIt = generatedParams.find(maskGen);
+            if (procedural && prevIt != generatedParams.end()) {
+                // Only regenerate and upload the parts of the mask which actually changed.
+                for (const auto &region : changedRegions(prevIt->second, *procedural, maskBuf.size)) {
+                    maskGen->generateRegion(input, maskBuf, region);
+                    if (packedIt != packedMasks.end()) { packedIt->second.pack(maskBuf, region); }
+                }
+                prevIt->second = *procedural;
+            } else {
+                maskGen->generate(input, maskBuf);
+                refine(maskGen, maskBuf);
+                if (packedIt != packedMasks.end()) { packedIt->second.pack(maskBuf); }
+                if (procedural) {
+                    generatedParams.insert_or_assign(maskGen, *procedural);
+                } else {
+                    generatedParams.erase(maskGen);
+                }
+            }
+            staleMasks.erase(maskGen);
             return maskBuf;
         } else {
             // Rely on mask() doing the first update for us.
@@ -143,20 +264,62 @@ namespace image {
 
     Mask &CompositionState::mask(AbstractMaskGenerator *maskGen) noexcept {
         if (auto it = generatedMasks.find(maskGen); it != generatedMasks.end()) {
+            if (staleMasks.contains(maskGen)) { return update(maskGen); }
             return it->second;
         }
-        auto &&[it, inserted] = generatedMasks.emplace(maskGen, input.size);
+        auto &&[it, inserted] =
+            generatedMasks.emplace(maskGen, reducedMaskSize(input.size, maskGen->resolutionDivisor()));
         auto &maskBuf = it->second;
         maskGen->generate(input, maskBuf);
-        maskBuf.pixelArray.buffer()->device = opencl::Manager::the()->bufferDevice;
-        maskBuf.pixelArray.buffer()->deviceMalloc();
-        maskBuf.pixelArray.buffer()->copyHostToDevice();
+        refine(maskGen, maskBuf);
+        if (auto procedural = maskGen->procedural(); procedural && !maskGen->isRefined()) {
+            generatedParams.insert_or_assign(maskGen, *procedural);
+        }
         return maskBuf;
     }
 
+    PackedMask &CompositionState::packedMask(AbstractMaskGenerator *maskGen) noexcept {
+        auto &maskBuf = mask(maskGen);
+        if (auto it = packedMasks.find(maskGen); it != packedMasks.end()) { return it->second; }
+        // Reduced resolution masks are stored as images so the kernel can upsample them with the sampler.
+        auto device = maskBuf.size == input.size ? opencl::Manager::the()->bufferDevice
+                                                 : PackedMask::makeImageDevice(maskFormat, maskBuf.size);
+        auto &&[it, inserted] = packedMasks.emplace(maskGen, PackedMask { maskFormat, maskBuf.size, device });
+        it->second.pack(maskBuf);
+        return it->second;
+    }
+
+    void CompositionState::refine(AbstractMaskGenerator *maskGen, Mask &maskBuf) noexcept {
+        if (!maskGen->isRefined()) { return; }
+        auto radius = std::max<memory::Size>(std::lround(maskGen->refinement.radius * maskBuf.width()), 1);
+        if (refineOnDevice) {
+            if (!guidedFilter) { guidedFilter = std::make_unique<GuidedFilter>(); }
+            guidedFilter->apply(input, maskBuf, maskGen->resolutionDivisor(), radius, maskGen->refinement.epsilon);
+        } else {
+            guidedFilterHost(input, maskBuf, maskGen->resolutionDivisor(), radius, maskGen->refinement.epsilon);
+        }
+    }
+
+    void CompositionState::invalidate(AbstractMaskGenerator *maskGen) noexcept {
+        if (generatedMasks.contains(maskGen)) { staleMasks.insert(maskGen); }
+    }
+
+    TiledMask &CompositionState::tiledMask(AbstractMaskGenerator *maskGen) noexcept {
+        auto it = tiledMasks.find(maskGen);
+        if (it == tiledMasks.end()) {
+            it = tiledMasks.emplace(maskGen, input.size).first;
+            it->second.setDevice(opencl::Manager::the()->bufferDevice);
+        }
+        auto &tiles = it->second;
+        maskGen->generateTiled(tiles);
+        tiles.upload();
+        return tiles;
+    }
+
     void Processor::init() noexcept {
         {
-            auto maybeProg = opencl::Manager::the()->programFromResource("kernels/kernels.cl");
+            auto options = kernelOptions(lutStorage == LutStorage::Buffer ? "-DLUT_BUFFER" : "");
+            auto maybeProg = opencl::Manager::the()->programFromResource("kernels/kernels.cl", options);
             if (maybeProg.hasError()) {
                 std::cerr << "Error loading program\n";
                 std::terminate();
@@ -164,28 +327,52 @@ namespace image {
             oclProgram = std::move(*maybeProg);
         }
         {
-            auto maybeKern = oclProgram.getKernel("apply3DLut_F32_F32");
+            auto maybeProg =
+                opencl::Manager::the()->programFromResource("kernels/kernels.cl", kernelOptions("-DLUT_CURVES"));
+            if (maybeProg.hasError()) {
+                std::cerr << "Error loading program\n";
+                std::terminate();
+            }
+            oclCurvesProgram = std::move(*maybeProg);
+        }
+        oclKernelsApplyLut = getApplyLutKernels(oclProgram);
+        oclKernelsApplyCurves = getApplyLutKernels(oclCurvesProgram);
+        {
+            auto maybeKern = oclProgram.getKernel("finalize_F32_U8");
             if (maybeKern.hasError()) {
                 std::cerr << "Error getting kernel from program\n";
                 std::terminate();
             }
-            oclKernelApplyLut = std::move(*maybeKern);
+            oclKernelFinalize = std::move(*maybeKern);
         }
         {
-            auto maybeKern = oclProgram.getKernel("apply3DLut_masked_F32_F32");
+            auto maybeKern = oclProgram.getKernel("finalizeHistogram_F32_U8");
             if (maybeKern.hasError()) {
                 std::cerr << "Error getting kernel from program\n";
                 std::terminate();
             }
-            oclKernelApplyLutMasked = std::move(*maybeKern);
+            oclKernelFinalizeHistogram = std::move(*maybeKern);
+            auto &context = opencl::Manager::the()->context;
+            histogramGroupSize = std::min({ maxHistogramGroupSize,
+                                            oclKernelFinalizeHistogram.getWorkGroupSize(context.getDeviceId()),
+                                            context.getDevice().maxWorkGroupSize });
         }
         {
-            auto maybeKern = oclProgram.getKernel("finalize_F32_U8");
+            auto maybeKern = oclProgram.getKernel("reduceHistogram_U32");
             if (maybeKern.hasError()) {
                 std::cerr << "Error getting kernel from program\n";
                 std::terminate();
             }
-            oclKernelFinalize = std::move(*maybeKern);
+            oclKernelReduceHistogram = std::move(*maybeKern);
+        }
+        {
+            auto numBins = 3 * histogram.numBuckets();
+            histogramPartialBins = NDArray<U32> { Shape { numBins, histogramGroups } };
+            histogramPartialBins.buffer()->setDevice(opencl::Manager::the()->bufferDevice);
+            histogramPartialBins.buffer()->deviceMalloc();
+            histogramBins = NDArray<U32> { Shape { numBins } };
+            histogramBins.buffer()->setDevice(opencl::Manager::the()->bufferDevice);
+            histogramBins.buffer()->deviceMalloc();
         }
         {
             cl_int ret;
@@ -200,6 +387,20 @@ namespace image {
             }
             oclSampler = opencl::SamplerHandle::takeOwnership(samplerHandle);
         }
+        {
+            // Reduced resolution masks are addressed in mask pixels so the kernel can line them up with the image.
+            cl_int ret;
+            cl_sampler samplerHandle = clCreateSampler(opencl::Manager::the()->context.getHandle().get(),
+                                                       false,
+                                                       CL_ADDRESS_CLAMP_TO_EDGE,
+                                                       CL_FILTER_LINEAR,
+                                                       &ret);
+            if (ret != CL_SUCCESS) {
+                std::cerr << opencl::Error(ret) << "\n";
+                std::terminate();
+            }
+            oclMaskSampler = opencl::SamplerHandle::takeOwnership(samplerHandle);
+        }
     }
 
     void Processor::setComposition(std::shared_ptr<Composition> comp) noexcept {
@@ -219,8 +420,55 @@ namespace image {
     }
 
     void Processor::process(ImageBuf<U8> &outFinal) noexcept {
-        assert(composition);
         assert(state.input.pixelArray.shape() == outFinal.pixelArray.shape());
+        if (isTiledOnHost) {
+            // The device is the host anyway, so skip the kernels and their pass over the image for each op.
+            TiledExecutor().run(opSeq, state, state.input, outFinal, isHistogramEnabled ? &histogram : nullptr);
+            return;
+        }
+        std::optional<PoolLease<ImageBuf<F32>>> lease;
+        auto &result = render(lease);
+
+        // Finalize the image and update the output ImageBuf.
+        if (isHistogramEnabled) {
+            finalizeWithHistogram(result, outFinal);
+        } else {
+            cl_uint inputPitch = result.rowPitch();
+            cl_uint outputPitch = outFinal.rowPitch();
+            auto saResult =
+                oclKernelFinalize.setArgs(result.pixelArray, inputPitch, outFinal.pixelArray, outputPitch);
+            if (saResult.hasError()) {
+                std::cerr << "Error setting kernel args: " << saResult.error().error << " (arg #"
+                          << saResult.error().argIdx << ")\n";
+                std::terminate();
+            }
+            auto runResult = oclKernelFinalize.run(opencl::Manager::the()->queue.getHandle(),
+                                                   Shape { outFinal.width(), outFinal.height() });
+            if (runResult.hasError()) {
+                std::cerr << "Error running kernel: " << runResult.error() << "\n";
+                std::terminate();
+            }
+        }
+        outFinal.pixelArray.buffer()->copyDeviceToHost();
+    }
+
+    template <class... Ts>
+    Expected<void, opencl::SetArgsError>
+    Processor::setLutKernelArgs(opencl::Kernel &kernel, Op &op, Ts &&...args) noexcept {
+        auto &lut = *op.lut;
+        if (op.kind == OpKind::Curves) {
+            cl_uint curveSize = lut.curves.size;
+            return kernel.setArgs(lut.curvesBuffer, curveSize, std::forward<Ts>(args)...);
+        }
+        if (lutStorage == LutStorage::Buffer) {
+            cl_uint lutSize = lut.lattice.size;
+            return kernel.setArgs(lut.latticeImage, lutSize, std::forward<Ts>(args)...);
+        }
+        return kernel.setArgs(lut.latticeImage, oclSampler, std::forward<Ts>(args)...);
+    }
+
+    ImageBuf<F32> &Processor::render(std::optional<PoolLease<ImageBuf<F32>>> &lease) noexcept {
+        assert(composition);
 
         // TODO: This function is rather horrible (mostly due to error handling boilerplate).
         // Would be nice to tidy it up.
@@ -238,17 +486,84 @@ namespace image {
             intermediateOut = state.intermediateImagePool->acquire();
 
             // Convenience.
-            auto &latticeImage = op.lut->latticeImage;
             auto &out = **intermediateOut;
-            opencl::Kernel *kernel;
-
-            if (op.maskGen) {
-                // Get mask buffer. Will create and generate if necessary.
-                auto &mask = state.mask(op.maskGen.get());
-                // Set-up masking kernel to apply LUT.
-                kernel = &oclKernelApplyLutMasked;
-                auto saResult = kernel->setArgs(
-                    latticeImage, oclSampler, currentIn->pixelArray, mask.pixelArray, out.pixelArray);
+            auto &kernels = op.kind == OpKind::Curves ? oclKernelsApplyCurves : oclKernelsApplyLut;
+            opencl::Kernel *kernel = nullptr;
+            // Intermediates are the input's size, so share its row pitch.
+            cl_uint pitch = currentIn->rowPitch();
+
+            if (auto procedural = op.maskGen && !op.maskGen->isRefined() ? op.maskGen->procedural() : std::nullopt) {
+                // Analytic mask: evaluated per-pixel by the kernel, so no mask buffer is needed.
+                kernel = &kernels.procedural;
+                cl_int maskKind = static_cast<cl_int>(procedural->kind);
+                auto saResult = setLutKernelArgs(*kernel,
+                                                 op,
+                                                 currentIn->pixelArray,
+                                                 pitch,
+                                                 maskKind,
+                                                 procedural->params.x,
+                                                 procedural->params.y,
+                                                 procedural->params.z,
+                                                 procedural->params.w,
+                                                 out.pixelArray);
+                if (saResult.hasError()) {
+                    std::cerr << "Error setting kernel args: " << saResult.error().error << " (arg #"
+                              << saResult.error().argIdx << ")\n";
+                    std::terminate();
+                }
+            } else if (op.maskGen && op.maskGen->isSparse() && !op.maskGen->isRefined()) {
+                // Sparse mask: only the non-uniform tiles are stored.
+                auto &tiles = state.tiledMask(op.maskGen.get());
+                kernel = &kernels.tiled;
+                cl_uint tilesX = tiles.tilesX;
+                auto saResult = setLutKernelArgs(*kernel,
+                                                 op,
+                                                 currentIn->pixelArray,
+                                                 pitch,
+                                                 tiles.tileTable,
+                                                 tilesX,
+                                                 tiles.tilePool,
+                                                 out.pixelArray);
+                if (saResult.hasError()) {
+                    std::cerr << "Error setting kernel args: " << saResult.error().error << " (arg #"
+                              << saResult.error().argIdx << ")\n";
+                    std::terminate();
+                }
+            } else if (op.maskGen && op.maskGen->resolutionDivisor() > 1) {
+                // Reduced resolution mask: the kernel upsamples it through the sampler, whatever the format.
+                auto &mask = state.packedMask(op.maskGen.get());
+                kernel = &kernels.maskedImage;
+                F32 maskScale = 1.0f / static_cast<F32>(op.maskGen->resolutionDivisor());
+                auto saResult = setLutKernelArgs(*kernel,
+                                                 op,
+                                                 currentIn->pixelArray,
+                                                 pitch,
+                                                 mask.data,
+                                                 oclMaskSampler,
+                                                 maskScale,
+                                                 out.pixelArray);
+                if (saResult.hasError()) {
+                    std::cerr << "Error setting kernel args: " << saResult.error().error << " (arg #"
+                              << saResult.error().argIdx << ")\n";
+                    std::terminate();
+                }
+            } else if (op.maskGen) {
+                // Get packed mask buffer. Will create and generate if necessary.
+                auto &mask = state.packedMask(op.maskGen.get());
+                // Set-up masking kernel for the mask's format to apply LUT.
+                kernel = &kernels.maskedF32;
+                switch (mask.format) {
+                case MaskFormat::F16:
+                    kernel = &kernels.maskedF16;
+                    break;
+                case MaskFormat::U8:
+                    kernel = &kernels.maskedU8;
+                    break;
+                case MaskFormat::F32:
+                    break;
+                }
+                auto saResult =
+                    setLutKernelArgs(*kernel, op, currentIn->pixelArray, pitch, mask.data, out.pixelArray);
                 if (saResult.hasError()) {
                     std::cerr << "Error setting kernel args: " << saResult.error().error << " (arg #"
                               << saResult.error().argIdx << ")\n";
@@ -256,8 +571,8 @@ namespace image {
                 }
             } else {
                 // Set-up non-masking kernel to apply LUT.
-                kernel = &oclKernelApplyLut;
-                auto saResult = kernel->setArgs(latticeImage, oclSampler, currentIn->pixelArray, out.pixelArray);
+                kernel = &kernels.unmasked;
+                auto saResult = setLutKernelArgs(*kernel, op, currentIn->pixelArray, pitch, out.pixelArray);
                 if (saResult.hasError()) {
                     std::cerr << "Error setting kernel args: " << saResult.error().error << " (arg #"
                               << saResult.error().argIdx << ")\n";
@@ -266,7 +581,7 @@ namespace image {
             }
             // Run the kernel.
             auto runResult =
-                kernel->run(opencl::Manager::the()->queue.getHandle(), Shape { out.width() * out.height() });
+                kernel->run(opencl::Manager::the()->queue.getHandle(), Shape { out.width(), out.height() });
             if (runResult.hasError()) {
                 std::cerr << "Error running kernel: " << runResult.error() << "\n";
                 std::terminate();
@@ -277,20 +592,57 @@ namespace image {
             currentIn = &out;
         }
 
-        // Finalize the image and update the output ImageBuf.
-        auto saResult = oclKernelFinalize.setArgs(currentIn->pixelArray, outFinal.pixelArray);
-        if (saResult.hasError()) {
-            std::cerr << "Error setting kernel args: " << saResult.error().error << " (arg #" << saResult.error().argIdx
-                      << ")\n";
-            std::terminate();
-        }
-        auto runResult = oclKernelFinalize.run(opencl::Manager::the()->queue.getHandle(),
-                                               Shape { outFinal.width() * outFinal.height() });
-        if (runResult.hasError()) {
-            std::cerr << "Error running kernel: " << runResult.error() << "\n";
-            std::terminate();
+        lease = intermediateIn;
+        return *currentIn;
+    }
+
+    void Processor::finalizeWithHistogram(ImageBuf<F32> &in, ImageBuf<U8> &outFinal) noexcept {
+        {
+            cl_uint inputPitch = in.rowPitch();
+            cl_uint outputPitch = outFinal.rowPitch();
+            cl_uint width = outFinal.width();
+            cl_uint numPixels = outFinal.width() * outFinal.height();
+            auto saResult = oclKernelFinalizeHistogram.setArgs(in.pixelArray,
+                                                               inputPitch,
+                                                               outFinal.pixelArray,
+                                                               outputPitch,
+                                                               width,
+                                                               numPixels,
+                                                               histogramPartialBins);
+            if (saResult.hasError()) {
+                std::cerr << "Error setting kernel args: " << saResult.error().error << " (arg #"
+                          << saResult.error().argIdx << ")\n";
+                std::terminate();
+            }
+            auto runResult = oclKernelFinalizeHistogram.run(opencl::Manager::the()->queue.getHandle(),
+                                                            Shape { histogramGroups * histogramGroupSize },
+                                                            Shape { histogramGroupSize });
+            if (runResult.hasError()) {
+                std::cerr << "Error running kernel: " << runResult.error() << "\n";
+                std::terminate();
+            }
         }
-        outFinal.pixelArray.buffer()->copyDeviceToHost();
+        {
+            cl_uint numGroups = histogramGroups;
+            auto saResult = oclKernelReduceHistogram.setArgs(histogramPartialBins, numGroups, histogramBins);
+            if (saResult.hasError()) {
+                std::cerr << "Error setting kernel args: " << saResult.error().error << " (arg #"
+                          << saResult.error().argIdx << ")\n";
+                std::terminate();
+            }
+            auto runResult = oclKernelReduceHistogram.run(opencl::Manager::the()->queue.getHandle(),
+                                                          Shape { histogramBins.size() });
+            if (runResult.hasError()) {
+                std::cerr << "Error running kernel: " << runResult.error() << "\n";
+                std::terminate();
+            }
+        }
+
+        // Only the summed bins come back to the host.
+        histogramBins.buffer()->copyDeviceToHost();
+        std::array<U32, 3 * Histogram<>::NUM_BUCKETS> counts;
+        std::copy(histogramBins.begin(), histogramBins.end(), counts.begin());
+        histogram.setCounts(counts);
     }
 
 }
@@ -1,37 +1,50 @@
 #include <image/Resource.hpp>
 
-#include <fstream>
-
 #include <image/IO.hpp>
-#include <image/luts/CubeFile.hpp>
 
 namespace image {
 
-    Expected<void, ResourceLoadError> ImageResource::load() noexcept {
+    Expected<void, ResourceLoadError> ImageResource::load(std::shared_ptr<memory::AbstractDevice> device,
+                                                          const ImageReadOptions &opts) noexcept {
         if (!filePath) {
             return success;
         }
-        auto result = readImageBufFromFile<F32>(*filePath);
-        if (result.hasValue()) {
-            data = result.value();
-            return success;
-        } else {
+        auto reader = ImageReader::open(*filePath, opts);
+        if (reader.hasError()) {
+            return Unexpected(ResourceLoadError { *filePath });
+        }
+        auto &img = data.emplace(reader->size());
+        isReduced = reader->isReduced();
+        ImageReader::BandCallback onBand;
+        if (device) {
+            img.pixelArray.buffer()->setDevice(device);
+            img.pixelArray.buffer()->deviceMalloc();
+            // Rows are copied whole, padding and all, so that each band is one contiguous copy.
+            memory::Size rowBytes = img.rowPitchBytes();
+            onBand = [&img, rowBytes](memory::Size firstRow, memory::Size numRows) {
+                img.pixelArray.buffer()->copyHostToDevice(
+                    memory::BufferRect { 0, firstRow, rowBytes, numRows, rowBytes });
+            };
+        }
+        auto readResult = reader->read(img, onBand);
+        // Band uploads are queued without waiting, so the host image has to stay as it is until they're done.
+        if (device) { img.pixelArray.buffer()->sync(); }
+        if (readResult.hasError()) {
+            unload();
             return Unexpected(ResourceLoadError { *filePath });
         }
+        return success;
     }
 
     Expected<void, ResourceLoadError> LutResource::load() noexcept {
         if (!filePath) {
             return success;
         }
-        std::ifstream s;
-        s.open(*filePath);
-        if (!s.is_open()) {
+        auto lut = luts::LutCache::shared().load(*filePath);
+        if (lut.hasError()) {
             return Unexpected(ResourceLoadError { *filePath });
         }
-        luts::CubeFile cube;
-        s >> cube;
-        data = cube.lattice();
+        data = *lut;
         return success;
     }
 
@@ -0,0 +1,100 @@
+#include <image/Scopes.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <image/Histogram.hpp>
+#include <image/Stopwatch.hpp>
+#include <image/TaskGraph.hpp>
+
+namespace image {
+
+    namespace {
+        /**
+         * @brief Write log scaled counts to density, so that sparse bins stay visible next to dense ones.
+         */
+        template <class Counts>
+        void normalise(const Counts &counts, NDArray<F32> &density) noexcept {
+            U32 maxCount = std::max<U32>(*std::max_element(counts.begin(), counts.end()), 1);
+            F32 scale = 1.0f / std::log1p(static_cast<F32>(maxCount));
+            auto out = density.begin();
+            for (auto count : counts) { *out++ = std::log1p(static_cast<F32>(count)) * scale; }
+        }
+    }
+
+    void Waveform::generate(const ImageBuf<U8> &img, memory::Size maxSamples) noexcept {
+        STOPWATCH("Generating waveform");
+        memory::Size stride = Histogram<>::strideFor(img.size, maxSamples);
+        memory::Size width = img.width();
+        memory::Size height = img.height();
+
+        // Each scope column covers its own range of image columns, so threads never share bins.
+        ThreadPool::shared().parallelFor(NUM_COLUMNS, [&](memory::Size c) {
+            // Channels are the fastest dimension, so a column's levels aren't contiguous: clear them one by one.
+            for (memory::Size l = 0; l < NUM_LEVELS; ++l) {
+                for (memory::Size ch = 0; ch < 3; ++ch) { counts.at(ch, c, l) = 0; }
+            }
+            memory::Size x0 = (c * width / NUM_COLUMNS + stride - 1) / stride * stride;
+            memory::Size x1 = (c + 1) * width / NUM_COLUMNS;
+            for (memory::Size y = 0; y < height; y += stride) {
+                for (memory::Size x = x0; x < x1; x += stride) {
+                    const auto &color = img.at(x, y);
+                    ++counts.at(0, c, Histogram<NUM_LEVELS>::bucket(color.r));
+                    ++counts.at(1, c, Histogram<NUM_LEVELS>::bucket(color.g));
+                    ++counts.at(2, c, Histogram<NUM_LEVELS>::bucket(color.b));
+                }
+            }
+        });
+        normalise(counts, density);
+    }
+
+    void Vectorscope::generate(const ImageBuf<U8> &img, memory::Size maxSamples) noexcept {
+        STOPWATCH("Generating vectorscope");
+        using Bins = std::vector<U32>;
+        memory::Size stride = Histogram<>::strideFor(img.size, maxSamples);
+        memory::Size width = img.width();
+        memory::Size rows = (img.height() + stride - 1) / stride;
+        memory::Size numChunks =
+            std::clamp<memory::Size>(ThreadPool::shared().numThreads(), 1, std::max<memory::Size>(rows, 1));
+        std::vector<Bins> chunkBins(numChunks);
+
+        // Bin each thread's share of the rows privately, and sum them in a TaskGraph, as in Histogram::generate().
+        auto binChunk = [&](memory::Size c) {
+            auto &bins = chunkBins[c];
+            bins.assign(SIZE * SIZE, 0);
+            for (memory::Size row = c * rows / numChunks; row < (c + 1) * rows / numChunks; ++row) {
+                for (memory::Size x = 0; x < width; x += stride) {
+                    const auto &color = img.at(x, row * stride);
+                    F32 r = static_cast<F32>(color.r) / 255.0f;
+                    F32 g = static_cast<F32>(color.g) / 255.0f;
+                    F32 b = static_cast<F32>(color.b) / 255.0f;
+                    F32 cb = -0.1146f * r - 0.3854f * g + 0.5f * b;
+                    F32 cr = 0.5f * r - 0.4542f * g - 0.0458f * b;
+                    auto u = Histogram<SIZE>::bucket(cb + 0.5f);
+                    auto v = Histogram<SIZE>::bucket(cr + 0.5f);
+                    ++bins[v * SIZE + u];
+                }
+            }
+        };
+        TaskGraph graph;
+        std::vector<TaskGraph::Node> chunkTasks(numChunks);
+        for (memory::Size c = 0; c < numChunks; ++c) {
+            chunkTasks[c] = graph.add([&binChunk, c] { binChunk(c); });
+        }
+
+        // Sum the chunks pairwise, ending up in the first chunk.
+        for (memory::Size step = 1; step < numChunks; step *= 2) {
+            for (memory::Size c = 0; c < numChunks - step; c += 2 * step) {
+                auto sum = [&dst = chunkBins[c], &src = chunkBins[c + step]] {
+                    #pragma omp simd
+                    for (memory::Size i = 0; i < SIZE * SIZE; ++i) { dst[i] += src[i]; }
+                };
+                chunkTasks[c] = graph.add(sum, { chunkTasks[c], chunkTasks[c + step] });
+            }
+        }
+        graph.run();
+        normalise(chunkBins.front(), density);
+    }
+
+}
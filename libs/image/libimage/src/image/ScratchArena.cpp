@@ -0,0 +1,39 @@
+#include <image/ScratchArena.hpp>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace image {
+
+    namespace {
+        /// Enough for a tile's working buffers, so most threads only ever need the one block.
+        constexpr std::size_t minBlockSize = 1 << 20;
+    }
+
+    ScratchArena &ScratchArena::local() noexcept {
+        thread_local ScratchArena arena;
+        return arena;
+    }
+
+    void *ScratchArena::allocBytes(std::size_t bytes) noexcept {
+        auto fit = [this, bytes]() -> void * {
+            auto &current = blocks[block];
+            auto base = reinterpret_cast<std::uintptr_t>(current.data.get());
+            std::size_t start = (base + offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT - base;
+            if (start + bytes > current.size) { return nullptr; }
+            offset = start + bytes;
+            return current.data.get() + start;
+        };
+
+        // Later blocks are left over from bigger scopes, so try them before making another.
+        for (; block < blocks.size(); ++block, offset = 0) {
+            if (auto *ptr = fit()) { return ptr; }
+        }
+        std::size_t size = std::max(bytes + ALIGNMENT, blocks.empty() ? minBlockSize : 2 * blocks.back().size);
+        blocks.push_back(Block { std::make_unique_for_overwrite<std::byte[]>(size), size });
+        block = blocks.size() - 1;
+        offset = 0;
+        return fit();
+    }
+
+}
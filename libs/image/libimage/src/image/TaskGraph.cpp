@@ -0,0 +1,42 @@
+#include <image/TaskGraph.hpp>
+
+#include <cassert>
+
+namespace image {
+
+    TaskGraph::Node TaskGraph::add(std::function<void()> f, std::initializer_list<Node> dependencies) noexcept {
+        Node node = tasks.size();
+        auto &task = tasks.emplace_back();
+        task.f = std::move(f);
+        task.numDependencies = dependencies.size();
+        for (auto dependency : dependencies) {
+            assert(dependency < node);
+            tasks[dependency].successors.push_back(node);
+        }
+        return node;
+    }
+
+    void TaskGraph::run(ThreadPool &pool) noexcept {
+        ThreadPool::Counter remaining { tasks.size() };
+        for (auto &task : tasks) { task.pending.store(task.numDependencies, std::memory_order_relaxed); }
+        for (Node node = 0; node < tasks.size(); ++node) {
+            if (tasks[node].numDependencies == 0) { start(pool, node, remaining); }
+        }
+        pool.wait(remaining);
+    }
+
+    void TaskGraph::start(ThreadPool &pool, Node node, ThreadPool::Counter &remaining) noexcept {
+        pool.submit([this, &pool, node, &remaining] {
+            auto &task = tasks[node];
+            task.f();
+            for (auto successor : task.successors) {
+                if (tasks[successor].pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    start(pool, successor, remaining);
+                }
+            }
+            // Last, as run() may return as soon as this reaches zero.
+            pool.complete(remaining);
+        }, &remaining);
+    }
+
+}
@@ -0,0 +1,167 @@
+#include <image/ThreadPool.hpp>
+
+#include <algorithm>
+#include <iterator>
+
+namespace image {
+
+    namespace {
+        /// The pool the current thread works for, if any, and its index in it.
+        thread_local const ThreadPool *currentPool = nullptr;
+        thread_local std::size_t currentWorker = 0;
+    }
+
+    ThreadPool &ThreadPool::shared() noexcept {
+        static ThreadPool pool(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+        return pool;
+    }
+
+    ThreadPool::ThreadPool(std::size_t numWorkers) noexcept {
+        workers.reserve(numWorkers);
+        for (std::size_t i = 0; i < numWorkers; ++i) { workers.push_back(std::make_unique<Worker>()); }
+        // Only start the threads once every worker exists, as they steal from each other.
+        for (std::size_t i = 0; i < numWorkers; ++i) {
+            workers[i]->thread = std::thread([this, i] { run(i); });
+        }
+    }
+
+    ThreadPool::~ThreadPool() noexcept {
+        {
+            std::scoped_lock lock(sleepMutex);
+            isStopping = true;
+        }
+        wake.notify_all();
+        for (auto &worker : workers) { worker->thread.join(); }
+    }
+
+    ThreadPool::Task ThreadPool::take(std::size_t self, const Counter *group) noexcept {
+        if (numQueued.load(std::memory_order_acquire) == 0) { return {}; }
+        auto matches = [group](const Queued &queued) { return !group || queued.group == group; };
+        auto pop = [this](std::deque<Queued> &tasks, auto it) {
+            auto task = std::move(it->task);
+            tasks.erase(it);
+            numQueued.fetch_sub(1, std::memory_order_relaxed);
+            return task;
+        };
+        if (self < workers.size()) {
+            auto &own = *workers[self];
+            std::scoped_lock lock(own.mutex);
+            if (auto it = std::find_if(own.tasks.rbegin(), own.tasks.rend(), matches); it != own.tasks.rend()) {
+                return pop(own.tasks, std::next(it).base());
+            }
+        }
+        // Start with the next worker along, so thieves spread over the victims.
+        for (std::size_t i = 1; i <= workers.size(); ++i) {
+            auto &victim = *workers[(self + i) % workers.size()];
+            std::scoped_lock lock(victim.mutex);
+            if (auto it = std::find_if(victim.tasks.begin(), victim.tasks.end(), matches); it != victim.tasks.end()) {
+                return pop(victim.tasks, it);
+            }
+        }
+        return {};
+    }
+
+    void ThreadPool::run(std::size_t self) noexcept {
+        currentPool = this;
+        currentWorker = self;
+        while (true) {
+            if (auto task = take(self)) {
+                task();
+                continue;
+            }
+            std::unique_lock lock(sleepMutex);
+            wake.wait(lock, [this] { return isStopping || numQueued.load(std::memory_order_acquire) > 0; });
+            if (isStopping) { return; }
+        }
+    }
+
+    void ThreadPool::notify() noexcept {
+        {
+            // Taking the lock orders this wake-up after any worker's check of numQueued, or waiter's of queueEpoch.
+            std::scoped_lock lock(sleepMutex);
+            ++queueEpoch;
+        }
+        wake.notify_all();
+    }
+
+    void ThreadPool::submit(Task task, const Counter *group) noexcept {
+        if (workers.empty()) {
+            task();
+            return;
+        }
+        std::size_t w = currentPool == this ? currentWorker
+                                            : nextWorker.fetch_add(1, std::memory_order_relaxed) % workers.size();
+        {
+            auto &worker = *workers[w];
+            std::scoped_lock lock(worker.mutex);
+            worker.tasks.push_back(Queued { std::move(task), group });
+            numQueued.fetch_add(1, std::memory_order_release);
+        }
+        notify();
+    }
+
+    void ThreadPool::complete(Counter &remaining) noexcept {
+        if (remaining.fetch_sub(1, std::memory_order_acq_rel) != 1) { return; }
+        {
+            // As in notify(): the waiter checks remaining under the lock before sleeping.
+            std::scoped_lock lock(sleepMutex);
+        }
+        wake.notify_all();
+    }
+
+    void ThreadPool::wait(const Counter &remaining) noexcept {
+        // Help with the caller's own tasks, which are either queued or running elsewhere. Any of them can be run
+        // here, and nested waits only need their own, so this can always finish even if every thread is waiting.
+        std::size_t self = currentPool == this ? currentWorker : workers.size();
+        while (remaining.load(std::memory_order_acquire) > 0) {
+            std::size_t seenEpoch;
+            {
+                std::scoped_lock lock(sleepMutex);
+                seenEpoch = queueEpoch;
+            }
+            if (auto task = take(self, &remaining)) {
+                task();
+                continue;
+            }
+            // Nothing of ours is queued: sleep until one finishes the group or more tasks are queued.
+            std::unique_lock lock(sleepMutex);
+            wake.wait(lock, [this, &remaining, seenEpoch] {
+                return remaining.load(std::memory_order_acquire) == 0 || queueEpoch != seenEpoch;
+            });
+        }
+    }
+
+    void ThreadPool::parallelForRanges(std::size_t count,
+                                       const std::function<void(std::size_t, std::size_t)> &f,
+                                       std::size_t grain) noexcept {
+        if (grain == 0) { grain = std::max<std::size_t>(count / (4 * numThreads()), 1); }
+        std::size_t numRanges = (count + grain - 1) / grain;
+        if (numRanges <= 1 || workers.empty()) {
+            if (count > 0) { f(0, count); }
+            return;
+        }
+
+        Counter remaining { numRanges - 1 };
+        auto runRange = [this, &f, &remaining, count, grain](std::size_t range) {
+            f(range * grain, std::min(count, (range + 1) * grain));
+            complete(remaining);
+        };
+        // The caller keeps the first range, and each worker gets a contiguous share of the rest.
+        for (std::size_t w = 0; w < workers.size(); ++w) {
+            std::size_t first = 1 + (numRanges - 1) * w / workers.size();
+            std::size_t last = 1 + (numRanges - 1) * (w + 1) / workers.size();
+            if (first == last) { continue; }
+            auto &worker = *workers[w];
+            std::scoped_lock lock(worker.mutex);
+            for (std::size_t range = first; range < last; ++range) {
+                worker.tasks.push_back(Queued { [&runRange, range] { runRange(range); }, &remaining });
+            }
+            numQueued.fetch_add(last - first, std::memory_order_release);
+        }
+        notify();
+
+        f(0, std::min(count, grain));
+        wait(remaining);
+    }
+
+}
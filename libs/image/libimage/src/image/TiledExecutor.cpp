@@ -0,0 +1,256 @@
+#include <image/TiledExecutor.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include <glm/gtc/packing.hpp>
+
+#include <image/CpuDispatch.hpp>
+#include <image/Mask.hpp>
+#include <image/ScratchArena.hpp>
+#include <image/Stopwatch.hpp>
+#include <image/TiledMask.hpp>
+
+namespace image {
+
+    namespace {
+        /**
+         * @brief Where an op's mask comes from, decided once per run in the same order as Processor::render().
+         */
+        struct TileOp {
+            enum class Source { None, Procedural, Tiled, ReducedPacked, Packed };
+
+            const Op *op;
+            Source source { Source::None };
+            ProceduralMask procedural {};
+            const TiledMask *tiles { nullptr };
+            const PackedMask *packed { nullptr };
+            F32 maskScale { 1.0f };
+        };
+
+        constexpr memory::Size histogramBins = 3 * Histogram<>::NUM_BUCKETS;
+
+        F32 packedValue(const PackedMask &mask, memory::Size index) noexcept {
+            switch (mask.format) {
+            case MaskFormat::F32:
+                return reinterpret_cast<const F32 *>(mask.data.data())[index];
+            case MaskFormat::F16:
+                return glm::unpackHalf1x16(reinterpret_cast<const U16 *>(mask.data.data())[index]);
+            case MaskFormat::U8:
+                return static_cast<F32>(mask.data.data()[index]) / 255.0f;
+            }
+            return 0.0f;
+        }
+
+        /**
+         * @brief Fill factors with the mask's coverage of count pixels along row y, starting at x.
+         */
+        IMAGE_CPU_DISPATCH
+        void rowFactors(const TileOp &tileOp,
+                        const ImageSize &size,
+                        memory::Size x,
+                        memory::Size y,
+                        memory::Size count,
+                        F32 *factors) noexcept {
+            switch (tileOp.source) {
+            case TileOp::Source::None:
+                break;
+            case TileOp::Source::Procedural: {
+                // As evaluateProceduralMask() in kernels.cl.
+                const auto &params = tileOp.procedural.params;
+                F32 rowProj = params.y * static_cast<F32>(y) / static_cast<F32>(size.y);
+                for (memory::Size i = 0; i < count; ++i) {
+                    F32 proj = params.x * static_cast<F32>(x + i) / static_cast<F32>(size.x) + rowProj;
+                    F32 value = 0.0f;
+                    if (proj >= params.w) {
+                        value = 1.0f;
+                    } else if (proj > params.z) {
+                        value = (proj - params.z) / (params.w - params.z);
+                    }
+                    factors[i] = std::pow(value, maskGamma);
+                }
+                break;
+            }
+            case TileOp::Source::Tiled: {
+                const auto &tiles = *tileOp.tiles;
+                memory::Size ty = y / TiledMask::tileSize;
+                memory::Size rowInTile = (y % TiledMask::tileSize) * TiledMask::tileSize;
+                for (memory::Size i = 0; i < count; ++i) {
+                    memory::Size px = x + i;
+                    I32 slot = tiles.tile(px / TiledMask::tileSize, ty);
+                    if (slot == TiledMask::emptyTile) {
+                        factors[i] = 0.0f;
+                    } else if (slot == TiledMask::fullTile) {
+                        factors[i] = 1.0f;
+                    } else {
+                        factors[i] = tiles.slotData(slot)[rowInTile + px % TiledMask::tileSize];
+                    }
+                }
+                break;
+            }
+            case TileOp::Source::ReducedPacked: {
+                // Bilinear, clamped to the edge, at the pixel's centre in mask pixels: as the kernel's sampler does.
+                const auto &mask = *tileOp.packed;
+                auto lastX = static_cast<I64>(mask.size.x) - 1;
+                auto lastY = static_cast<I64>(mask.size.y) - 1;
+                F32 v = (static_cast<F32>(y) + 0.5f) * tileOp.maskScale - 0.5f;
+                auto y0 = static_cast<I64>(std::floor(v));
+                F32 fy = v - static_cast<F32>(y0);
+                memory::Size row0 = std::clamp<I64>(y0, 0, lastY) * mask.size.x;
+                memory::Size row1 = std::clamp<I64>(y0 + 1, 0, lastY) * mask.size.x;
+                for (memory::Size i = 0; i < count; ++i) {
+                    F32 u = (static_cast<F32>(x + i) + 0.5f) * tileOp.maskScale - 0.5f;
+                    auto x0 = static_cast<I64>(std::floor(u));
+                    F32 fx = u - static_cast<F32>(x0);
+                    memory::Size col0 = std::clamp<I64>(x0, 0, lastX);
+                    memory::Size col1 = std::clamp<I64>(x0 + 1, 0, lastX);
+                    F32 top = std::lerp(packedValue(mask, row0 + col0), packedValue(mask, row0 + col1), fx);
+                    F32 bottom = std::lerp(packedValue(mask, row1 + col0), packedValue(mask, row1 + col1), fx);
+                    factors[i] = std::lerp(top, bottom, fy);
+                }
+                break;
+            }
+            case TileOp::Source::Packed: {
+                memory::Size first = y * size.x + x;
+                for (memory::Size i = 0; i < count; ++i) { factors[i] = packedValue(*tileOp.packed, first + i); }
+                break;
+            }
+            }
+        }
+
+        /**
+         * @brief Mix an op's output with its input, in place, by the mask's factors.
+         */
+        IMAGE_CPU_DISPATCH
+        void blend(ColorRGB<F32> *mapped,
+                   const ColorRGB<F32> *current,
+                   const F32 *factors,
+                   memory::Size count) noexcept {
+            #pragma omp simd
+            for (memory::Size i = 0; i < count; ++i) {
+                mapped[i] = mapped[i] * factors[i] + current[i] * (1.0f - factors[i]);
+            }
+        }
+
+        /**
+         * @brief Convert count channel values to bytes, as finalize_F32_U8's convert_uchar3_sat() does: truncating,
+         * saturating at 0 and 255, and with NaN as 0.
+         */
+        IMAGE_CPU_DISPATCH
+        void quantize(const F32 *src, U8 *dst, memory::Size count) noexcept {
+            for (memory::Size i = 0; i < count; ++i) {
+                F32 value = src[i] * 256.0f;
+                dst[i] = value > 0.0f ? static_cast<U8>(std::min(value, 255.0f)) : 0;
+            }
+        }
+    }
+
+    void TiledExecutor::run(const OpSequence &seq,
+                            CompositionState &state,
+                            const ImageBuf<F32> &in,
+                            ImageBuf<U8> &out,
+                            Histogram<> *histogram) noexcept {
+        STOPWATCH("Processing tiles");
+        // Masks may need generating, which can't happen from the tiles, so find them all up front.
+        std::vector<TileOp> tileOps;
+        tileOps.reserve(seq.ops.size());
+        for (const auto &op : seq.ops) {
+            TileOp &tileOp = tileOps.emplace_back(TileOp { &op });
+            const auto &maskGen = op.maskGen;
+            if (!maskGen) { continue; }
+            if (auto procedural = maskGen->isRefined() ? std::nullopt : maskGen->procedural()) {
+                tileOp.source = TileOp::Source::Procedural;
+                tileOp.procedural = *procedural;
+            } else if (maskGen->isSparse() && !maskGen->isRefined()) {
+                tileOp.source = TileOp::Source::Tiled;
+                tileOp.tiles = &state.tiledMask(maskGen.get());
+            } else {
+                auto divisor = maskGen->resolutionDivisor();
+                tileOp.source = divisor > 1 ? TileOp::Source::ReducedPacked : TileOp::Source::Packed;
+                tileOp.packed = &state.packedMask(maskGen.get());
+                tileOp.maskScale = 1.0f / static_cast<F32>(divisor);
+            }
+        }
+
+        std::array<std::atomic<U32>, histogramBins> bins {};
+        const auto size = in.size;
+        memory::Size numPixels = size.x * size.y;
+        memory::Size numTiles = (numPixels + TILE_PIXELS - 1) / TILE_PIXELS;
+        pool.parallelFor(numTiles, [&](memory::Size tile) {
+            auto &arena = ScratchArena::local();
+            ScratchArena::Scope scope(arena);
+            ColorRGB<F32> *colors[2] = { arena.alloc<ColorRGB<F32>>(TILE_PIXELS),
+                                         arena.alloc<ColorRGB<F32>>(TILE_PIXELS) };
+            F32 *factors = arena.alloc<F32>(TILE_PIXELS);
+            memory::Size begin = tile * TILE_PIXELS;
+            memory::Size count = std::min(TILE_PIXELS, numPixels - begin);
+            // The tile may span several rows, which are padded in the images, and masks are evaluated along one row
+            // at a time too, so the tile is worked through in runs of pixels along a row. The working buffers are
+            // packed, with run i pixels into the tile.
+            auto forEachRun = [&](auto &&f) {
+                for (memory::Size i = 0; i < count;) {
+                    memory::Size x = (begin + i) % size.x;
+                    memory::Size y = (begin + i) / size.x;
+                    memory::Size run = std::min(count - i, size.x - x);
+                    f(x, y, i, run);
+                    i += run;
+                }
+            };
+            // Until the first op has run, pixels are read straight from the input.
+            const ColorRGB<F32> *current = nullptr;
+            auto source = [&in, &current](memory::Size x, memory::Size y, memory::Size i) {
+                return current ? current + i : reinterpret_cast<const ColorRGB<F32> *>(in.row(y)) + x;
+            };
+            int next = 0;
+
+            for (const auto &tileOp : tileOps) {
+                auto *mapped = colors[next];
+                const auto &lut = *tileOp.op->lut;
+                forEachRun([&](memory::Size x, memory::Size y, memory::Size i, memory::Size run) {
+                    const auto *src = source(x, y, i);
+                    if (tileOp.op->kind == OpKind::Curves) {
+                        lut.curves.map(src, mapped + i, run);
+                    } else {
+                        lut.interpolator.map(src, mapped + i, run);
+                    }
+                    if (tileOp.source != TileOp::Source::None) {
+                        rowFactors(tileOp, size, x, y, run, factors + i);
+                        blend(mapped + i, src, factors + i, run);
+                    }
+                });
+                current = mapped;
+                next = 1 - next;
+            }
+
+            // Finalize, as finalize_F32_U8, counting into local bins so the shared ones are only touched once a tile.
+            std::array<U32, histogramBins> tileBins {};
+            forEachRun([&](memory::Size x, memory::Size y, memory::Size i, memory::Size run) {
+                U8 *dst = out.row(y) + 3 * x;
+                quantize(reinterpret_cast<const F32 *>(source(x, y, i)), dst, 3 * run);
+                if (histogram) {
+                    for (memory::Size p = 0; p < run; ++p) {
+                        for (memory::Size c = 0; c < 3; ++c) {
+                            ++tileBins[c * Histogram<>::NUM_BUCKETS + dst[3 * p + c]];
+                        }
+                    }
+                }
+            });
+            if (histogram) {
+                for (memory::Size i = 0; i < histogramBins; ++i) {
+                    if (tileBins[i]) { bins[i].fetch_add(tileBins[i], std::memory_order_relaxed); }
+                }
+            }
+        }, 1);
+
+        if (histogram) {
+            std::array<U32, histogramBins> counts;
+            std::transform(bins.begin(), bins.end(), counts.begin(), [](const auto &bin) { return bin.load(); });
+            histogram->setCounts(counts);
+        }
+    }
+
+}
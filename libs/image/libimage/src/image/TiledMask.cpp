@@ -0,0 +1,154 @@
+#include <image/TiledMask.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <image/ThreadPool.hpp>
+
+namespace image {
+
+    namespace {
+        constexpr memory::Size tilePixels = TiledMask::tileSize * TiledMask::tileSize;
+        constexpr memory::Size tileBytes = tilePixels * sizeof(F32);
+    }
+
+    TiledMask::TiledMask(const ImageSize &size) noexcept
+      : size(size)
+      , tilesX(detail::roundUpToMultiple(size.x, tileSize) / tileSize)
+      , tilesY(detail::roundUpToMultiple(size.y, tileSize) / tileSize)
+      , tileTable(Shape { tilesX, tilesY }) {
+        std::fill(tileTable.begin(), tileTable.end(), emptyTile);
+        growPool();
+    }
+
+    F32 TiledMask::at(memory::Size x, memory::Size y) const noexcept {
+        auto slot = tile(x / tileSize, y / tileSize);
+        if (slot == emptyTile) { return 0.0f; }
+        if (slot == fullTile) { return 1.0f; }
+        return tilePool.at(x % tileSize, y % tileSize, slot);
+    }
+
+    F32 *TiledMask::editTile(memory::Size tx, memory::Size ty) noexcept {
+        auto &entry = tileTable.at(tx, ty);
+        if (entry >= 0) {
+            dirtySlots.insert(entry);
+            return slotData(entry);
+        }
+        F32 fill = entry == fullTile ? 1.0f : 0.0f;
+        // Allocating may grow the pool so must happen before taking any pointers into it.
+        auto slot = allocateSlot();
+        tileTable.at(tx, ty) = slot;
+        isTableDirty = true;
+        dirtySlots.insert(slot);
+        auto data = slotData(slot);
+        std::fill(data, data + tilePixels, fill);
+        return data;
+    }
+
+    void TiledMask::fillTile(memory::Size tx, memory::Size ty, I32 state) noexcept {
+        assert(state == emptyTile || state == fullTile);
+        auto &entry = tileTable.at(tx, ty);
+        if (entry == state) { return; }
+        if (entry >= 0) {
+            freeSlots.push_back(entry);
+            dirtySlots.erase(entry);
+        }
+        entry = state;
+        isTableDirty = true;
+    }
+
+    void TiledMask::compactTile(memory::Size tx, memory::Size ty) noexcept {
+        auto slot = tile(tx, ty);
+        if (slot < 0) { return; }
+        auto data = slotData(slot);
+        memory::Size w = std::min(tileSize, size.x - tx * tileSize);
+        memory::Size h = std::min(tileSize, size.y - ty * tileSize);
+        F32 first = data[0];
+        if (first != 0.0f && first != 1.0f) { return; }
+        for (memory::Size y = 0; y < h; ++y) {
+            auto row = data + y * tileSize;
+            if (std::any_of(row, row + w, [first](F32 v) { return v != first; })) { return; }
+        }
+        fillTile(tx, ty, first == 0.0f ? emptyTile : fullTile);
+    }
+
+    void TiledMask::clear() noexcept {
+        std::fill(tileTable.begin(), tileTable.end(), emptyTile);
+        freeSlots.clear();
+        dirtySlots.clear();
+        usedSlots = 0;
+        isTableDirty = true;
+        sourceEpoch = 0;
+        sourceCount = 0;
+        sourceSubCount = 0;
+    }
+
+    void TiledMask::setDevice(std::shared_ptr<memory::AbstractDevice> dev) noexcept {
+        device = dev;
+        tileTable.buffer()->setDevice(device);
+        tileTable.buffer()->deviceMalloc();
+        tilePool.buffer()->setDevice(device);
+        tilePool.buffer()->deviceMalloc();
+        isTableDirty = true;
+        isPoolReallocated = true;
+    }
+
+    void TiledMask::upload() noexcept {
+        if (!device) { return; }
+        if (isTableDirty) { tileTable.buffer()->copyHostToDevice(); }
+        if (isPoolReallocated) {
+            tilePool.buffer()->copyHostToDevice();
+        } else {
+            // Upload runs of consecutive dirty slots, one slot per "row".
+            auto it = dirtySlots.begin();
+            while (it != dirtySlots.end()) {
+                auto first = *it;
+                auto last = first;
+                while (++it != dirtySlots.end() && *it == last + 1) { last = *it; }
+                auto y = static_cast<memory::Size>(first);
+                auto height = static_cast<memory::Size>(last - first + 1);
+                tilePool.buffer()->copyHostToDevice(memory::BufferRect { 0, y, tileBytes, height, tileBytes });
+            }
+            // The uploads are queued without waiting, and the slots may be rewritten by the next update.
+            if (!dirtySlots.empty()) { tilePool.buffer()->sync(); }
+        }
+        dirtySlots.clear();
+        isTableDirty = false;
+        isPoolReallocated = false;
+    }
+
+    void TiledMask::toDense(Mask &mask) const noexcept {
+        assert(mask.size == size);
+        ThreadPool::shared().parallelFor(size.y, [&](memory::Size y) {
+            for (memory::Size x = 0; x < size.x; ++x) {
+                mask.pixelArray.at(x, y) = std::pow(at(x, y), 1.0f / maskGamma);
+            }
+        });
+    }
+
+    I32 TiledMask::allocateSlot() noexcept {
+        if (!freeSlots.empty()) {
+            auto slot = freeSlots.back();
+            freeSlots.pop_back();
+            return slot;
+        }
+        if (usedSlots == capacity) { growPool(); }
+        return static_cast<I32>(usedSlots++);
+    }
+
+    void TiledMask::growPool() noexcept {
+        // Always keep at least one slot so that there's a valid buffer to give to kernels.
+        memory::Size newCapacity = std::max<memory::Size>(capacity * 2, 1);
+        NDArray<F32> newPool { Shape { tileSize, tileSize, newCapacity } };
+        if (capacity > 0) { std::memcpy(newPool.data(), tilePool.data(), capacity * tileBytes); }
+        tilePool = std::move(newPool);
+        capacity = newCapacity;
+        if (device) {
+            tilePool.buffer()->setDevice(device);
+            tilePool.buffer()->deviceMalloc();
+        }
+        isPoolReallocated = true;
+    }
+
+}
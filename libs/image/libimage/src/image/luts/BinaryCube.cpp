@@ -0,0 +1,191 @@
+#include <image/luts/BinaryCube.hpp>
+
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <image/MappedFile.hpp>
+
+namespace image::luts {
+
+    namespace {
+        constexpr std::array<char, 8> binaryCubeMagic { 'P', 'V', 'C', 'U', 'B', 'E', '\0', '\0' };
+        constexpr U32 binaryCubeVersion = 2;
+
+        struct BinaryCubeHeader {
+            std::array<char, 8> magic;
+            U32 version;
+            U32 size;
+            U32 size1D;
+            std::array<F32, 3> domainMin;
+            std::array<F32, 3> domainMax;
+            std::array<F32, 3> domainMin1D;
+            std::array<F32, 3> domainMax1D;
+            I64 sourceModified;
+            U64 sourceSize;
+            U32 sourcePathLength;
+            U32 titleLength;
+        };
+        static_assert(std::is_trivially_copyable_v<BinaryCubeHeader>);
+
+        /// Unique to this thread of this process, so that concurrent writers never share a temporary file.
+        Path temporaryPath(const Path &path) noexcept {
+#ifdef _WIN32
+            auto pid = _getpid();
+#else
+            auto pid = getpid();
+#endif
+            std::ostringstream suffix;
+            suffix << "." << pid << "." << std::hex << std::hash<std::thread::id> {}(std::this_thread::get_id())
+                   << ".tmp";
+            Path out = path;
+            out += suffix.str();
+            return out;
+        }
+    }
+
+    std::optional<SourceStamp> SourceStamp::of(const Path &path) noexcept {
+        std::error_code ec;
+        auto modified = std::filesystem::last_write_time(path, ec);
+        if (ec) { return std::nullopt; }
+        auto size = std::filesystem::file_size(path, ec);
+        if (ec) { return std::nullopt; }
+        return SourceStamp { static_cast<I64>(modified.time_since_epoch().count()), static_cast<U64>(size) };
+    }
+
+    Path binaryCubePath(const Path &sourcePath) noexcept {
+        Path cacheDir;
+        if (auto xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+            cacheDir = xdg;
+        } else if (auto home = std::getenv("HOME"); home && *home) {
+            cacheDir = Path { home } / ".cache";
+        } else {
+            std::error_code ec;
+            cacheDir = std::filesystem::temp_directory_path(ec);
+        }
+        // The source path is stored in the file too, so a hash collision just means a cache miss.
+        std::error_code ec;
+        auto absolute = std::filesystem::absolute(sourcePath, ec);
+        std::ostringstream name;
+        name << std::hex << std::hash<String> {}(absolute.string()) << ".lutcache";
+        return cacheDir / "photoView" / "luts" / name.str();
+    }
+
+    Expected<CubeFile, CubeFileError>
+    readBinaryCube(const Path &path, const Path &sourcePath, const SourceStamp &stamp) noexcept {
+        auto file = MappedFile::open(path);
+        if (file.hasError()) { return Unexpected(CubeFileError { path, file.error().reason }); }
+
+        BinaryCubeHeader header;
+        if (file->size() < sizeof(header)) { return Unexpected(CubeFileError { path, "Truncated header" }); }
+        std::memcpy(&header, file->data(), sizeof(header));
+        if (header.magic != binaryCubeMagic || header.version != binaryCubeVersion) {
+            return Unexpected(CubeFileError { path, "Not a binary cube of this version" });
+        }
+        if (SourceStamp { header.sourceModified, header.sourceSize } != stamp) {
+            return Unexpected(CubeFileError { path, "Source has changed" });
+        }
+
+        memory::Size size = header.size;
+        memory::Size size1D = header.size1D;
+        memory::Size tableOffset = sizeof(header) + header.sourcePathLength + header.titleLength;
+        if (file->size() < tableOffset) { return Unexpected(CubeFileError { path, "Wrong size" }); }
+        // The sizes come from the file, so bound them by what's mapped before cubing them, which could overflow.
+        memory::Size numEntries = (file->size() - tableOffset) / sizeof(ColorRGB<F32>);
+        if (size1D > numEntries || (size > 0 && numEntries / size / size < size)) {
+            return Unexpected(CubeFileError { path, "Wrong size" });
+        }
+        memory::Size table1DBytes = size1D * sizeof(ColorRGB<F32>);
+        memory::Size tableBytes = size * size * size * sizeof(ColorRGB<F32>);
+        if (file->size() != tableOffset + table1DBytes + tableBytes) {
+            return Unexpected(CubeFileError { path, "Wrong size" });
+        }
+        StringView storedPath { file->data() + sizeof(header), header.sourcePathLength };
+        std::error_code ec;
+        if (storedPath != std::filesystem::absolute(sourcePath, ec).string()) {
+            return Unexpected(CubeFileError { path, "Made from another source" });
+        }
+
+        CubeFile cube;
+        cube.size = size;
+        cube.size1D = size1D;
+        cube.title = String { file->data() + sizeof(header) + header.sourcePathLength, header.titleLength };
+        cube.domainMin = ColorRGB<F32> { header.domainMin[0], header.domainMin[1], header.domainMin[2] };
+        cube.domainMax = ColorRGB<F32> { header.domainMax[0], header.domainMax[1], header.domainMax[2] };
+        cube.domainMin1D = ColorRGB<F32> { header.domainMin1D[0], header.domainMin1D[1], header.domainMin1D[2] };
+        cube.domainMax1D = ColorRGB<F32> { header.domainMax1D[0], header.domainMax1D[1], header.domainMax1D[2] };
+        if (size1D > 0) {
+            cube.table1D = NDArray<ColorRGB<F32>>(Shape { size1D });
+            std::memcpy(cube.table1D.data(), file->data() + tableOffset, table1DBytes);
+        }
+        if (size > 0) {
+            cube.table = NDArray<ColorRGB<F32>>(Shape { size, size, size });
+            std::memcpy(cube.table.data(), file->data() + tableOffset + table1DBytes, tableBytes);
+        }
+        return cube;
+    }
+
+    Expected<void, CubeFileError> writeBinaryCube(const Path &path,
+                                                  const CubeFile &cube,
+                                                  const Path &sourcePath,
+                                                  const SourceStamp &stamp) noexcept {
+        std::error_code ec;
+        std::filesystem::create_directories(path.parent_path(), ec);
+        if (ec) { return Unexpected(CubeFileError { path, ec.message() }); }
+
+        auto absoluteSource = std::filesystem::absolute(sourcePath, ec).string();
+        BinaryCubeHeader header {
+            binaryCubeMagic,
+            binaryCubeVersion,
+            static_cast<U32>(cube.size),
+            static_cast<U32>(cube.size1D),
+            { cube.domainMin.r, cube.domainMin.g, cube.domainMin.b },
+            { cube.domainMax.r, cube.domainMax.g, cube.domainMax.b },
+            { cube.domainMin1D.r, cube.domainMin1D.g, cube.domainMin1D.b },
+            { cube.domainMax1D.r, cube.domainMax1D.g, cube.domainMax1D.b },
+            stamp.modified,
+            stamp.size,
+            static_cast<U32>(absoluteSource.size()),
+            static_cast<U32>(cube.title.size()),
+        };
+
+        Path tmpPath = temporaryPath(path);
+        {
+            std::ofstream out { tmpPath, std::ios::binary | std::ios::trunc };
+            out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            out.write(absoluteSource.data(), static_cast<std::streamsize>(absoluteSource.size()));
+            out.write(cube.title.data(), static_cast<std::streamsize>(cube.title.size()));
+            // Tables in file order, 1D first. An absent table's array isn't empty, so sizes come from the cube.
+            out.write(reinterpret_cast<const char *>(cube.table1D.data()),
+                      static_cast<std::streamsize>(cube.size1D * sizeof(ColorRGB<F32>)));
+            out.write(reinterpret_cast<const char *>(cube.table.data()),
+                      static_cast<std::streamsize>(cube.size * cube.size * cube.size * sizeof(ColorRGB<F32>)));
+            // Closing flushes what's still buffered, which can fail too.
+            out.close();
+            if (!out) {
+                std::filesystem::remove(tmpPath, ec);
+                return Unexpected(CubeFileError { tmpPath, "Failed to write" });
+            }
+        }
+        std::filesystem::rename(tmpPath, path, ec);
+        if (ec) {
+            auto message = ec.message();
+            std::filesystem::remove(tmpPath, ec);
+            return Unexpected(CubeFileError { path, message });
+        }
+        return success;
+    }
+
+}
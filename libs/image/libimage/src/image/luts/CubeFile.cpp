@@ -1,86 +1,271 @@
 #include <image/luts/CubeFile.hpp>
 
+#include <algorithm>
+#include <array>
+#include <charconv>
 #include <cmath>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <optional>
+#include <tuple>
+#include <utility>
+
+#include <image/MappedFile.hpp>
+#include <image/Stopwatch.hpp>
+#include <image/luts/BinaryCube.hpp>
 
 namespace image::luts {
 
     namespace {
-        std::istream &operator>>(std::istream &input, ColorRGB<F32> &color) {
-            input >> color.r;
-            input >> color.g;
-            input >> color.b;
-            return input;
+        /// Enough for any float in its shortest round-tripping form, such as -1.1754944e-38.
+        constexpr memory::Size MAX_FLOAT_CHARS { 16 };
+        constexpr memory::Size MAX_LINE_CHARS { 3 * MAX_FLOAT_CHARS + 3 };
+
+        /**
+         * @brief Format color as a table line at p, which must have room for MAX_LINE_CHARS. Returns the end.
+         */
+        char *formatColor(char *p, const ColorRGB<F32> &color) noexcept {
+            p = std::to_chars(p, p + MAX_FLOAT_CHARS, color.r).ptr;
+            *p++ = ' ';
+            p = std::to_chars(p, p + MAX_FLOAT_CHARS, color.g).ptr;
+            *p++ = ' ';
+            p = std::to_chars(p, p + MAX_FLOAT_CHARS, color.b).ptr;
+            *p++ = '\n';
+            return p;
+        }
+    }
+
+    namespace {
+        bool isSpace(char c) noexcept { return c == ' ' || c == '\t' || c == '\r'; }
+
+        StringView trimStart(StringView text) noexcept {
+            while (!text.empty() && isSpace(text.front())) { text.remove_prefix(1); }
+            return text;
+        }
+
+        /**
+         * @brief Parse count whitespace separated floats from the start of line.
+         */
+        bool parseFloats(StringView line, F32 *out, memory::Size count) noexcept {
+            const char *p = line.data();
+            const char *end = p + line.size();
+            for (memory::Size i = 0; i < count; ++i) {
+                while (p < end && isSpace(*p)) { ++p; }
+                auto [next, ec] = std::from_chars(p, end, out[i]);
+                if (ec != std::errc {}) { return false; }
+                p = next;
+            }
+            return true;
         }
 
-        std::ostream &operator<<(std::ostream &output, const ColorRGB<F32> &color) {
-            output << color.r << " " << color.g << " " << color.b;
-            return output;
+        bool parseColor(StringView line, ColorRGB<F32> &color) noexcept {
+            std::array<F32, 3> values;
+            if (!parseFloats(line, values.data(), 3)) { return false; }
+            color = ColorRGB<F32> { values[0], values[1], values[2] };
+            return true;
+        }
+
+        CubeFileError lineError(memory::Size lineNumber, const String &reason) noexcept {
+            return CubeFileError { {}, "Line " + std::to_string(lineNumber) + ": " + reason };
+        }
+
+        bool isUniform(const ColorRGB<F32> &color) noexcept { return color.r == color.g && color.g == color.b; }
+
+        // Lookups divide by the domain's width, so every channel's domain must be non-empty.
+        bool isValidDomain(const ColorRGB<F32> &min, const ColorRGB<F32> &max) noexcept {
+            return min.r < max.r && min.g < max.g && min.b < max.b;
         }
     }
 
-    std::istream &operator>>(std::istream &stream, CubeFile &cube) {
-        String field;
+    Expected<CubeFile, CubeFileError> CubeFile::parse(StringView text) noexcept {
+        CubeFile cube;
+        memory::Size count = 0;
+        memory::Size lineNumber = 0;
+        std::optional<std::pair<ColorRGB<F32>, ColorRGB<F32>>> domain;
+        bool hasRange1D = false;
+        bool hasRange3D = false;
+        auto parseSize = [](StringView args, std::size_t &size) {
+            auto [next, ec] = std::from_chars(args.data(), args.data() + args.size(), size);
+            return ec == std::errc {} && size >= 2;
+        };
+        auto parseRange = [](StringView args, ColorRGB<F32> &min, ColorRGB<F32> &max) {
+            std::array<F32, 2> values;
+            if (!parseFloats(args, values.data(), 2)) { return false; }
+            min = ColorRGB<F32> { values[0] };
+            max = ColorRGB<F32> { values[1] };
+            return true;
+        };
+        while (!text.empty()) {
+            auto lineEnd = text.find('\n');
+            auto line = trimStart(text.substr(0, lineEnd));
+            text.remove_prefix(lineEnd == StringView::npos ? text.size() : lineEnd + 1);
+            ++lineNumber;
 
-        while (!stream.eof()) {
-            char first = static_cast<char>(stream.peek());
-            if (first == '\n' || first == '\r' || first == '\t' || first == ' ') {
-                stream.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-                continue;
-            } else if (first == '#') {
-                stream.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            if (line.empty() || line.front() == '#') { continue; }
+            if (line.front() >= 'A' && line.front() <= 'Z') {
+                auto keywordEnd = std::min(line.find_first_of(" \t\r"), line.size());
+                auto keyword = line.substr(0, keywordEnd);
+                auto args = trimStart(line.substr(keywordEnd));
+                if (keyword == "TITLE") {
+                    auto first = args.find('"');
+                    auto last = args.rfind('"');
+                    if (first != StringView::npos && last > first) {
+                        cube.title = args.substr(first + 1, last - first - 1);
+                    }
+                } else if (keyword == "LUT_3D_SIZE") {
+                    if (!parseSize(args, cube.size)) { return Unexpected(lineError(lineNumber, "Bad size")); }
+                    cube.table = NDArray<ColorRGB<F32>>(Shape { cube.size, cube.size, cube.size });
+                } else if (keyword == "LUT_1D_SIZE") {
+                    if (!parseSize(args, cube.size1D)) { return Unexpected(lineError(lineNumber, "Bad size")); }
+                    cube.table1D = NDArray<ColorRGB<F32>>(Shape { cube.size1D });
+                } else if (keyword == "DOMAIN_MIN" || keyword == "DOMAIN_MAX") {
+                    if (!domain) { domain.emplace(ColorRGB<F32> { 0.0f }, ColorRGB<F32> { 1.0f }); }
+                    auto &bound = keyword == "DOMAIN_MIN" ? domain->first : domain->second;
+                    if (!parseColor(args, bound)) { return Unexpected(lineError(lineNumber, "Bad domain")); }
+                } else if (keyword == "LUT_1D_INPUT_RANGE") {
+                    if (!parseRange(args, cube.domainMin1D, cube.domainMax1D)) {
+                        return Unexpected(lineError(lineNumber, "Bad input range"));
+                    }
+                    hasRange1D = true;
+                } else if (keyword == "LUT_3D_INPUT_RANGE") {
+                    if (!parseRange(args, cube.domainMin, cube.domainMax)) {
+                        return Unexpected(lineError(lineNumber, "Bad input range"));
+                    }
+                    hasRange3D = true;
+                }
                 continue;
-            } else if (!(first >= 'A' && first <= 'Z')) {
-                break;
-            }
-            stream >> field;
-            if (field == "TITLE") {
-                stream.ignore(std::numeric_limits<std::streamsize>::max(), '"');
-                char buf[250];
-                stream.getline(buf, std::numeric_limits<std::streamsize>::max(), '"');
-                cube.title = buf;
-            } else if (field == "LUT_3D_SIZE") {
-                stream >> cube.size;
-            } else if (field == "DOMAIN_MIN") {
-                stream >> cube.domainMin;
-            } else if (field == "DOMAIN_MAX") {
-                stream >> cube.domainMax;
-            } else {
-                stream.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
             }
+
+            // The 1D table comes first when there are both.
+            memory::Size count1D = cube.size1D;
+            memory::Size count3D = cube.size * cube.size * cube.size;
+            if (count1D + count3D == 0) { return Unexpected(lineError(lineNumber, "Table before its size")); }
+            if (count == count1D + count3D) { return Unexpected(lineError(lineNumber, "Too many table entries")); }
+            auto &entry = count < count1D ? cube.table1D.at(count) : cube.table.at(count - count1D);
+            if (!parseColor(line, entry)) { return Unexpected(lineError(lineNumber, "Bad entry")); }
+            ++count;
         }
 
-        if (cube.size == 0) {
-            return stream;
+        if (cube.size == 0 && cube.size1D == 0) {
+            return Unexpected(CubeFileError { {}, "Missing LUT_3D_SIZE or LUT_1D_SIZE" });
+        }
+        if (count != cube.size1D + cube.size * cube.size * cube.size) {
+            return Unexpected(CubeFileError { {}, "Too few table entries" });
+        }
+        // The domain is the file's input domain, so it belongs to whichever table is applied first, unless that
+        // table's domain is given by its input range.
+        if (domain && cube.size1D > 0 && !hasRange1D) {
+            std::tie(cube.domainMin1D, cube.domainMax1D) = *domain;
+        } else if (domain && cube.size > 0 && !hasRange3D) {
+            std::tie(cube.domainMin, cube.domainMax) = *domain;
         }
+        if ((cube.size1D > 0 && !isValidDomain(cube.domainMin1D, cube.domainMax1D)) ||
+            (cube.size > 0 && !isValidDomain(cube.domainMin, cube.domainMax))) {
+            return Unexpected(CubeFileError { {}, "Empty domain" });
+        }
+        return cube;
+    }
 
-        cube.table = NDArray<ColorRGB<F32>>(Shape{ cube.size, cube.size, cube.size });
+    Expected<CubeFile, CubeFileError> CubeFile::load(const Path &path) noexcept {
+        auto stamp = SourceStamp::of(path);
+        if (!stamp) { return Unexpected(CubeFileError { path, "Can't read file" }); }
+        auto cachePath = binaryCubePath(path);
+        if (auto cached = readBinaryCube(cachePath, path, *stamp); cached.hasValue()) { return cached; }
 
-        for (std::size_t i = 0; i < cube.table.size(); i++) {
-            stream >> cube.table.at(i);
+        Expected<CubeFile, CubeFileError> cube = [&path]() -> Expected<CubeFile, CubeFileError> {
+            STOPWATCH("Parsing cube file");
+            auto file = MappedFile::open(path);
+            if (file.hasError()) { return Unexpected(CubeFileError { path, file.error().reason }); }
+            return CubeFile::parse(file->view());
+        }();
+        if (cube.hasError()) { return Unexpected(CubeFileError { path, cube.error().reason }); }
+
+        // Caching is only an optimisation, so failing to write the cache isn't an error.
+        auto writeResult = writeBinaryCube(cachePath, *cube, path, *stamp);
+        if (writeResult.hasError()) {
+            std::cerr << "[CubeFile] Couldn't cache " << path << ": " << writeResult.error().reason << "\n";
         }
+        return cube;
+    }
 
+    std::istream &operator>>(std::istream &stream, CubeFile &cube) {
+        String text { std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>() };
+        auto result = CubeFile::parse(text);
+        if (result.hasError()) {
+            stream.setstate(std::ios::failbit);
+            return stream;
+        }
+        cube = std::move(*result);
         return stream;
     }
 
-    std::ostream &operator<<(std::ostream &stream, const CubeFile &cube) {
-        if (!cube.title.empty()) {
-            stream << "TITLE " << cube.title << std::endl;
+    Expected<void, CubeFileError> CubeFile::save(const Path &path) const noexcept {
+        STOPWATCH("Writing cube file");
+        // DOMAIN_MIN and DOMAIN_MAX are the only per-channel domain, so only one table's can differ between channels.
+        if (size1D > 0 && size > 0 && !(isUniform(domainMin1D) && isUniform(domainMax1D)) &&
+            !(isUniform(domainMin) && isUniform(domainMax))) {
+            return Unexpected(CubeFileError { path, "Can't write per-channel domains for both tables" });
         }
+        std::ofstream file(path, std::ios::binary);
+        if (!file) { return Unexpected(CubeFileError { path, "Can't open file for writing" }); }
+        file << *this;
+        file.close();
+        if (!file) { return Unexpected(CubeFileError { path, "Can't write file" }); }
+        return success;
+    }
 
-        stream << "LUT_3D_SIZE " << cube.size << std::endl;
-
-        stream << "DOMAIN_MIN " << cube.domainMin << std::endl;
-        stream << "DOMAIN_MAX " << cube.domainMax << std::endl;
+    std::ostream &operator<<(std::ostream &stream, const CubeFile &cube) {
+        // The table is formatted into a buffer with to_chars and written a chunk at a time, rather than a value at a
+        // time through the stream's locale-aware formatting.
+        std::array<char, 64 * 1024> buffer;
+        char *p = buffer.data();
+        auto text = [&p](StringView chars) { p = std::copy(chars.begin(), chars.end(), p); };
+        auto number = [&p](F32 value) { p = std::to_chars(p, p + MAX_FLOAT_CHARS, value).ptr; };
+        auto line = [&p, &text](StringView keyword, const ColorRGB<F32> &color) {
+            text(keyword);
+            p = formatColor(p, color);
+        };
 
-        for (const auto& color : cube.table) {
-            stream << color << "\n";
+        if (!cube.title.empty()) { stream << "TITLE \"" << cube.title << "\"\n"; }
+        if (cube.size1D > 0) { stream << "LUT_1D_SIZE " << cube.size1D << "\n"; }
+        if (cube.size > 0) { stream << "LUT_3D_SIZE " << cube.size << "\n"; }
+        auto range = [&](StringView keyword, const ColorRGB<F32> &min, const ColorRGB<F32> &max) {
+            text(keyword);
+            number(min.r);
+            text(" ");
+            number(max.r);
+            text("\n");
+        };
+        // An input range is the same for every channel, so a shaper file gives the table whose domain differs between
+        // channels by DOMAIN_MIN and DOMAIN_MAX, and the other by its input range. save() rejects both differing.
+        bool is3DUniform = isUniform(cube.domainMin) && isUniform(cube.domainMax);
+        if (cube.size1D > 0 && cube.size > 0 && !is3DUniform) {
+            range("LUT_1D_INPUT_RANGE ", cube.domainMin1D, cube.domainMax1D);
+            line("DOMAIN_MIN ", cube.domainMin);
+            line("DOMAIN_MAX ", cube.domainMax);
+        } else if (cube.size1D > 0) {
+            line("DOMAIN_MIN ", cube.domainMin1D);
+            line("DOMAIN_MAX ", cube.domainMax1D);
+            if (cube.size > 0) { range("LUT_3D_INPUT_RANGE ", cube.domainMin, cube.domainMax); }
+        } else {
+            line("DOMAIN_MIN ", cube.domainMin);
+            line("DOMAIN_MAX ", cube.domainMax);
         }
-
+        auto write = [&](const ColorRGB<F32> &color) {
+            if (buffer.end() - p < static_cast<std::ptrdiff_t>(MAX_LINE_CHARS)) {
+                stream.write(buffer.data(), p - buffer.data());
+                p = buffer.data();
+            }
+            p = formatColor(p, color);
+        };
+        if (cube.size1D > 0) { std::for_each(cube.table1D.begin(), cube.table1D.end(), write); }
+        if (cube.size > 0) { std::for_each(cube.table.begin(), cube.table.end(), write); }
+        stream.write(buffer.data(), p - buffer.data());
         return stream;
     }
 
-    CubeFile::CubeFile(Lattice3D &lattice) noexcept
+    CubeFile::CubeFile(const Lattice3D &lattice) noexcept
         : size(lattice.size)
         , domainMin(lattice.domainMin)
         , domainMax(lattice.domainMax)
@@ -90,7 +275,15 @@ namespace image::luts {
         Lattice3D out(size);
         out.domainMin = domainMin;
         out.domainMax = domainMax;
-        out.table = table;
+        if (size > 0) { out.table = table; }
+        return out;
+    }
+
+    Lattice1D CubeFile::curves() const noexcept {
+        Lattice1D out(size1D);
+        out.domainMin = domainMin1D;
+        out.domainMax = domainMax1D;
+        if (size1D > 0) { out.table = table1D; }
         return out;
     }
 
@@ -0,0 +1,155 @@
+#include <image/luts/Hald.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <future>
+#include <utility>
+#include <vector>
+
+#include <image/Stopwatch.hpp>
+#include <image/ThreadPool.hpp>
+
+namespace image {
+
+    namespace {
+        /// Rows generated and written at a time by writeHald().
+        constexpr std::size_t HALD_BAND_HEIGHT { 16 };
+
+        /**
+         * @brief Split a resampled node's position in source nodes into the node before it and the distance past it.
+         */
+        inline std::pair<std::size_t, F32> split(std::size_t node, F32 scale, std::size_t sourceSize) noexcept {
+            F32 x = static_cast<F32>(node) * scale;
+            auto x0 = std::min(static_cast<std::size_t>(x), sourceSize - 2);
+            return { x0, x - static_cast<F32>(x0) };
+        }
+
+        /**
+         * @brief Write a Hald image of the given level whose nodes are node(r, g, b), a band of rows at a time.
+         */
+        template <class F>
+        Expected<void, ImageIOError> writeHald(const Path &path, std::size_t level, OIIO::TypeDesc format, F node) {
+            std::size_t latticeSize = level * level;
+            std::size_t width = latticeSize * level;
+            auto out = OIIO::ImageOutput::create(path.string());
+            if (!out) { return Unexpected(ImageIOError(path, OIIO::geterror())); }
+            OIIO::ImageSpec spec(static_cast<int>(width), static_cast<int>(width), 3, format);
+            if (!out->open(path.string(), spec)) { return Unexpected(ImageIOError(path, out->geterror())); }
+
+            // One band is generated while the other is being written, as in ExportJob. Bands must be written in
+            // order, so only one write is ever in flight.
+            std::array<std::vector<F32>, 2> bands;
+            for (auto &band : bands) { band.resize(HALD_BAND_HEIGHT * width * 3); }
+            std::future<bool> pendingWrite;
+            for (std::size_t row = 0, i = 0; row < width; row += HALD_BAND_HEIGHT, i ^= 1) {
+                std::size_t numRows = std::min(HALD_BAND_HEIGHT, width - row);
+                F32 *band = bands[i].data();
+                // Each image row holds level rows of the lattice, red varying fastest.
+                ThreadPool::shared().parallelFor(numRows, [&](std::size_t y) {
+                    F32 *line = band + y * width * 3;
+                    std::size_t firstNode = (row + y) * level;
+                    for (std::size_t x = 0; x < width; ++x) {
+                        std::size_t gb = firstNode + x / latticeSize;
+                        ColorRGB<F32> color = node(x % latticeSize, gb % latticeSize, gb / latticeSize);
+                        line[3 * x] = color.r;
+                        line[3 * x + 1] = color.g;
+                        line[3 * x + 2] = color.b;
+                    }
+                }, 1);
+                if (pendingWrite.valid() && !pendingWrite.get()) {
+                    return Unexpected(ImageIOError(path, out->geterror()));
+                }
+                int yBegin = static_cast<int>(row);
+                int yEnd = static_cast<int>(row + numRows);
+                pendingWrite = std::async(std::launch::async, [&out, yBegin, yEnd, band] {
+                    return out->write_scanlines(yBegin, yEnd, 0, OIIO::TypeDescFromC<F32>::value(), band);
+                });
+            }
+            if (pendingWrite.valid() && !pendingWrite.get()) { return Unexpected(ImageIOError(path, out->geterror())); }
+            if (!out->close()) { return Unexpected(ImageIOError(path, out->geterror())); }
+            return success;
+        }
+    }
+
+    Expected<void, ImageIOError> writeHaldToFile(const Path &path, std::size_t level, OIIO::TypeDesc format) noexcept {
+        STOPWATCH("Writing Hald image");
+        if (level < 2) { return Unexpected(ImageIOError { path, "Hald images must be at least level 2" }); }
+        std::size_t latticeSize = level * level;
+        std::vector<F32> values(latticeSize);
+        for (std::size_t i = 0; i < latticeSize; ++i) {
+            values[i] = static_cast<F32>(i) / static_cast<F32>(latticeSize - 1);
+        }
+        return writeHald(path, level, format, [&values](std::size_t r, std::size_t g, std::size_t b) {
+            return ColorRGB<F32> { values[r], values[g], values[b] };
+        });
+    }
+
+    Expected<void, ImageIOError> writeHaldToFile(const Path &path,
+                                                 const luts::Lattice3D &lattice,
+                                                 OIIO::TypeDesc format) noexcept {
+        STOPWATCH("Writing Hald image");
+        std::size_t level = 0;
+        while ((level + 1) * (level + 1) <= lattice.size) { ++level; }
+        if (level < 2 || level * level != lattice.size) {
+            return Unexpected(ImageIOError { path, "Hald images need a square number of nodes per side, at least 4" });
+        }
+        return writeHald(path, level, format, [&lattice](std::size_t r, std::size_t g, std::size_t b) {
+            return lattice.table.at(r, g, b);
+        });
+    }
+
+    std::size_t haldLatticeSize(memory::Size width) noexcept {
+        for (std::size_t level = 2; level * level * level <= width; ++level) {
+            if (level * level * level == width) { return level * level; }
+        }
+        return 0;
+    }
+
+    luts::Lattice3D haldToLattice(const ImageBuf<U16> &image, std::size_t latticeSize) noexcept {
+        std::size_t sourceSize = haldLatticeSize(image.width());
+        assert(sourceSize > 0 && image.width() == image.height());
+        auto node = [&image, sourceSize](std::size_t r, std::size_t g, std::size_t b) {
+            // Nodes run along the rows, red fastest, wrapping from the end of one row to the start of the next.
+            std::size_t index = r + (g + b * sourceSize) * sourceSize;
+            const U16 *pixel = image.row(index / image.width()) + 3 * (index % image.width());
+            return ColorRGB<F32> { conv<F32, U16>(pixel[0]), conv<F32, U16>(pixel[1]), conv<F32, U16>(pixel[2]) };
+        };
+
+        luts::Lattice3D lattice(latticeSize);
+        F32 scale = static_cast<F32>(sourceSize - 1) / static_cast<F32>(latticeSize - 1);
+        // Only the source nodes around each resampled node are ever converted.
+        ThreadPool::shared().parallelFor(latticeSize, [&](std::size_t b) {
+            auto [b0, fb] = split(b, scale, sourceSize);
+            for (std::size_t g = 0; g < latticeSize; ++g) {
+                auto [g0, fg] = split(g, scale, sourceSize);
+                for (std::size_t r = 0; r < latticeSize; ++r) {
+                    auto [r0, fr] = split(r, scale, sourceSize);
+                    auto c00 = mix(fr, node(r0, g0, b0), node(r0 + 1, g0, b0));
+                    auto c10 = mix(fr, node(r0, g0 + 1, b0), node(r0 + 1, g0 + 1, b0));
+                    auto c01 = mix(fr, node(r0, g0, b0 + 1), node(r0 + 1, g0, b0 + 1));
+                    auto c11 = mix(fr, node(r0, g0 + 1, b0 + 1), node(r0 + 1, g0 + 1, b0 + 1));
+                    lattice.table.at(r, g, b) = mix(fb, mix(fg, c00, c10), mix(fg, c01, c11));
+                }
+            }
+        });
+        return lattice;
+    }
+
+    Expected<luts::Lattice3D, ImageIOError> readHaldFromFile(const Path &path, std::size_t latticeSize) noexcept {
+        STOPWATCH("Reading Hald image");
+        // Every pixel is a lattice node, so the file must be read at full size even if it has a smaller MIP level.
+        auto reader = ImageReader::open(path, ImageReadOptions { .halfSize = false });
+        if (reader.hasError()) { return Unexpected(reader.error()); }
+        auto size = reader->size();
+        if (size.x != size.y || haldLatticeSize(size.x) == 0) {
+            return Unexpected(ImageIOError { path, "Image isn't a Hald CLUT: it must be L^3 pixels square" });
+        }
+        // 16 bits keeps the precision of 16-bit Halds at half the memory of floats.
+        ImageBuf<U16> image { size };
+        auto readResult = reader->read(image);
+        if (readResult.hasError()) { return Unexpected(readResult.error()); }
+        return haldToLattice(image, latticeSize);
+    }
+
+}
@@ -0,0 +1,48 @@
+#include <image/luts/Lattice1D.hpp>
+
+#include <algorithm>
+
+#include <image/CpuDispatch.hpp>
+
+namespace image::luts {
+
+    Lattice1D::Lattice1D() noexcept : Lattice1D(0) {}
+
+    Lattice1D::Lattice1D(std::size_t size) noexcept
+        : size(size)
+        , table(Shape{ size }) {}
+
+    ColorRGB<F32> Lattice1D::map(const ColorRGB<F32> &color) const noexcept {
+        ColorRGB<F32> out;
+        map(&color, &out, 1);
+        return out;
+    }
+
+    IMAGE_CPU_DISPATCH
+    void Lattice1D::map(const ColorRGB<F32> *in, ColorRGB<F32> *out, memory::Size count) const noexcept {
+        // Work on the channels directly, as TetrahedralInterpolator does.
+        static_assert(sizeof(ColorRGB<F32>) == 3 * sizeof(F32));
+        const F32 *src = reinterpret_cast<const F32 *>(in);
+        F32 *dst = reinterpret_cast<F32 *>(out);
+        const F32 *nodes = reinterpret_cast<const F32 *>(table.data());
+        auto maxBase = static_cast<I32>(size - 2);
+        auto last = static_cast<F32>(size - 1);
+        F32 offset[3];
+        F32 scale[3];
+        for (int c = 0; c < 3; ++c) {
+            scale[c] = last / (domainMax[c] - domainMin[c]);
+            offset[c] = -domainMin[c] * scale[c];
+        }
+
+        #pragma omp simd
+        for (memory::Size i = 0; i < 3 * count; ++i) {
+            auto c = static_cast<I32>(i % 3);
+            F32 x = std::clamp(src[i] * scale[c] + offset[c], 0.0f, last);
+            I32 x0 = std::min(static_cast<I32>(x), maxBase);
+            F32 f = x - static_cast<F32>(x0);
+            I32 node = 3 * x0 + c;
+            dst[i] = (1.0f - f) * nodes[node] + f * nodes[node + 3];
+        }
+    }
+
+}
@@ -0,0 +1,124 @@
+#include <image/luts/LutCache.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+
+#include <image/luts/Hald.hpp>
+
+namespace image::luts {
+
+    namespace {
+        Expected<std::shared_ptr<PreparedLut>, LutLoadError> loadLut(const Path &path) noexcept {
+            auto lut = std::make_shared<PreparedLut>();
+            auto ext = path.extension().string();
+            std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+            if (ext == ".cube") {
+                auto cube = CubeFile::load(path);
+                if (cube.hasError()) { return Unexpected(LutLoadError { path, cube.error().reason }); }
+                lut->curves = cube->curves();
+                lut->lattice = cube->lattice();
+            } else {
+                auto hald = readHaldFromFile(path, Lattice3D::PROCESSING_SIZE);
+                if (hald.hasError()) { return Unexpected(LutLoadError { path, hald.error().reason }); }
+                lut->lattice = std::move(*hald);
+            }
+            if (lut->lattice.size > 0) { lut->interpolator.load(lut->lattice); }
+            return lut;
+        }
+    }
+
+    void PreparedLut::map(const ColorRGB<F32> *in, ColorRGB<F32> *out, memory::Size count) const noexcept {
+        if (curves.size == 0) {
+            interpolator.map(in, out, count);
+            return;
+        }
+        if (lattice.size == 0) {
+            curves.map(in, out, count);
+            return;
+        }
+        // Shape a block at a time, so the shaped colors are still in cache when they're looked up in the lattice.
+        std::array<ColorRGB<F32>, 256> shaped;
+        for (memory::Size first = 0; first < count; first += shaped.size()) {
+            auto n = std::min<memory::Size>(shaped.size(), count - first);
+            curves.map(in + first, shaped.data(), n);
+            interpolator.map(shaped.data(), out + first, n);
+        }
+    }
+
+    memory::Size PreparedLut::byteSize() const noexcept {
+        return (curves.size + lattice.size * lattice.size * lattice.size) * sizeof(ColorRGB<F32>) +
+               interpolator.byteSize();
+    }
+
+    LutCache &LutCache::shared() noexcept {
+        static LutCache cache;
+        return cache;
+    }
+
+    Expected<std::shared_ptr<const PreparedLut>, LutLoadError> LutCache::load(const Path &path) noexcept {
+        auto stamp = SourceStamp::of(path);
+        if (!stamp) { return Unexpected(LutLoadError { path, "Can't read file" }); }
+        auto key = path.string();
+
+        {
+            std::scoped_lock lock(mutex);
+            if (auto found = index.find(key); found != index.end()) {
+                if (found->second->stamp == *stamp) {
+                    entries.splice(entries.begin(), entries, found->second);
+                    return found->second->lut;
+                }
+                // The file has changed since it was cached.
+                erase(found->second);
+            }
+        }
+
+        // Load without holding the lock, so that loading one LUT doesn't hold up getting others.
+        auto loaded = loadLut(path);
+        if (loaded.hasError()) { return Unexpected(loaded.error()); }
+        auto lut = std::move(*loaded);
+
+        std::scoped_lock lock(mutex);
+        if (auto found = index.find(key); found != index.end()) {
+            // Someone else loaded it in the meantime.
+            if (found->second->stamp == *stamp) { return found->second->lut; }
+            erase(found->second);
+        }
+        memory::Size lutBytes = lut->byteSize();
+        entries.push_front(Entry { path, *stamp, lut, lutBytes });
+        index.emplace(key, entries.begin());
+        bytes += lutBytes;
+        evict();
+        return std::shared_ptr<const PreparedLut> { std::move(lut) };
+    }
+
+    memory::Size LutCache::byteSize() const noexcept {
+        std::scoped_lock lock(mutex);
+        return bytes;
+    }
+
+    void LutCache::setCapacity(memory::Size capacityBytes) noexcept {
+        std::scoped_lock lock(mutex);
+        capacity = capacityBytes;
+        evict();
+    }
+
+    void LutCache::clear() noexcept {
+        std::scoped_lock lock(mutex);
+        entries.clear();
+        index.clear();
+        bytes = 0;
+    }
+
+    void LutCache::erase(std::list<Entry>::iterator it) noexcept {
+        bytes -= it->bytes;
+        index.erase(it->path.string());
+        entries.erase(it);
+    }
+
+    void LutCache::evict() noexcept {
+        // Always keep the most recently used LUT, even if it's bigger than the whole capacity.
+        while (bytes > capacity && entries.size() > 1) { erase(std::prev(entries.end())); }
+    }
+
+}
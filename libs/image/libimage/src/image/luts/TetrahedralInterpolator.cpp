@@ -1,59 +1,89 @@
 #include <image/luts/TetrahedralInterpolator.hpp>
 
-#include <utility>
+#include <algorithm>
 
-#include <image/NDArray.hpp>
+#include <image/CpuDispatch.hpp>
 
 namespace image::luts {
 
     void TetrahedralInterpolator::load(const Lattice3D& lattice) noexcept {
         latticeSize = lattice.size;
-        cubeTable = NDArray<SimpleCube>(Shape { latticeSize - 1, latticeSize - 1, latticeSize - 1 });
-        auto sizef = static_cast<F32>(latticeSize - 1);
-        for (std::size_t b = 0 ; b < latticeSize - 1 ; ++b) {
-            for (std::size_t g = 0 ; g < latticeSize - 1 ; ++g) {
-                for (std::size_t r = 0 ; r < latticeSize - 1 ; ++r) {
-                    auto& cube = cubeTable.at(r, g, b);
-                    cube.inVerts = {
-                        static_cast<glm::vec3>(glm::u64vec3(r, g, b)) / sizef,
-                        static_cast<glm::vec3>(glm::u64vec3(r + 1, g, b)) / sizef,
-                        static_cast<glm::vec3>(glm::u64vec3(r, g + 1, b)) / sizef,
-                        static_cast<glm::vec3>(glm::u64vec3(r + 1, g + 1, b)) / sizef,
-                        static_cast<glm::vec3>(glm::u64vec3(r, g, b + 1)) / sizef,
-                        static_cast<glm::vec3>(glm::u64vec3(r + 1, g, b + 1)) / sizef,
-                        static_cast<glm::vec3>(glm::u64vec3(r , g + 1, b + 1)) / sizef,
-                        static_cast<glm::vec3>(glm::u64vec3(r + 1, g + 1, b + 1)) / sizef,
-                    };
-                    cube.outVerts = {
-                        lattice.table.at(r, g, b),
-                        lattice.table.at(r + 1, g, b),
-                        lattice.table.at(r, g + 1, b),
-                        lattice.table.at(r + 1, g + 1, b),
-                        lattice.table.at(r, g, b + 1),
-                        lattice.table.at(r + 1, g, b + 1),
-                        lattice.table.at(r, g + 1, b + 1),
-                        lattice.table.at(r + 1, g + 1, b + 1)
-                    };
-                }
-            }
+        table.assign(lattice.table.begin(), lattice.table.end());
+        // Nodes are spread over the domain, so inputs are scaled from it to node coordinates.
+        auto last = static_cast<F32>(latticeSize - 1);
+        for (int c = 0; c < 3; ++c) {
+            inputScale[c] = last / (lattice.domainMax[c] - lattice.domainMin[c]);
+            inputOffset[c] = -lattice.domainMin[c] * inputScale[c];
         }
     }
 
-    const SimpleCube &TetrahedralInterpolator::findCube(ColorRGB<F32> color) const {
-        auto coordf = color * static_cast<F32>(latticeSize - 1); // Cooridnate scaled-up to size of LUT.
-        auto baseCoord = glm::clamp(static_cast<glm::u64vec3>(glm::floor(coordf)), static_cast<std::size_t>(0), latticeSize - 2); // Truncate to int and clamp to find index of cube.
-        return cubeTable.at(baseCoord.r, baseCoord.g, baseCoord.b);
+    ColorRGB<F32> TetrahedralInterpolator::map(const ColorRGB<F32>& color) const noexcept {
+        ColorRGB<F32> out;
+        map(&color, &out, 1);
+        return out;
     }
 
-    ColorRGB<F32> TetrahedralInterpolator::map(const ColorRGB<F32>& color) const noexcept {
-        if (glm::length(color - inCache) < 0.01f) {
-            return outCache;
+    /*
+     * Each lattice cell splits into six tetrahedra along its grey diagonal, and which one a color falls in only
+     * depends on the order of its fractional coordinates. Walking from the cell's first corner along the axes in that
+     * order visits the tetrahedron's corners, and the differences between the sorted fractions are their weights.
+     * Corners are selected rather than branched on, so that the loop vectorises into gathers.
+     */
+    IMAGE_CPU_DISPATCH
+    void TetrahedralInterpolator::map(const ColorRGB<F32> *in, ColorRGB<F32> *out, memory::Size count) const noexcept {
+        // Work on the channels directly: the vectoriser can't see through the color type's unions.
+        static_assert(sizeof(ColorRGB<F32>) == 3 * sizeof(F32));
+        const F32 *src = reinterpret_cast<const F32 *>(in);
+        F32 *dst = reinterpret_cast<F32 *>(out);
+        const F32 *nodes = reinterpret_cast<const F32 *>(table.data());
+        auto maxBase = static_cast<I32>(latticeSize - 2);
+        auto scale = static_cast<F32>(latticeSize - 1);
+        // 32-bit offsets are enough for any lattice that fits in memory, and are what gather instructions take.
+        I32 sr = 3;
+        I32 sg = static_cast<I32>(3 * latticeSize);
+        I32 sb = static_cast<I32>(3 * latticeSize * latticeSize);
+        F32 scaleR = inputScale.r, scaleG = inputScale.g, scaleB = inputScale.b;
+        F32 offsetR = inputOffset.r, offsetG = inputOffset.g, offsetB = inputOffset.b;
+
+        #pragma omp simd
+        for (memory::Size i = 0; i < count; ++i) {
+            // Out of range colors are clamped to the lattice, like other LUT implementations do.
+            F32 r = std::clamp(src[3 * i] * scaleR + offsetR, 0.0f, scale);
+            F32 g = std::clamp(src[3 * i + 1] * scaleG + offsetG, 0.0f, scale);
+            F32 b = std::clamp(src[3 * i + 2] * scaleB + offsetB, 0.0f, scale);
+            // The coordinates aren't negative, so truncating floors them.
+            I32 r0 = std::min(static_cast<I32>(r), maxBase);
+            I32 g0 = std::min(static_cast<I32>(g), maxBase);
+            I32 b0 = std::min(static_cast<I32>(b), maxBase);
+            F32 fr = r - static_cast<F32>(r0);
+            F32 fg = g - static_cast<F32>(g0);
+            F32 fb = b - static_cast<F32>(b0);
+            I32 base = r0 * sr + g0 * sg + b0 * sb;
+
+            // Ties are broken in opposite orders, so the largest and smallest axes always differ.
+            // Plain & rather than && avoids branches.
+            bool rIsMax = (fr >= fg) & (fr >= fb);
+            bool gIsMax = !rIsMax & (fg >= fb);
+            bool bIsMin = (fb <= fg) & (fb <= fr);
+            bool gIsMin = !bIsMin & (fg <= fr);
+            I32 maxStride = rIsMax ? sr : (gIsMax ? sg : sb);
+            I32 minStride = bIsMin ? sb : (gIsMin ? sg : sr);
+            F32 fMax = std::max(fr, std::max(fg, fb));
+            F32 fMin = std::min(fr, std::min(fg, fb));
+            F32 fMid = fr + fg + fb - fMax - fMin;
+
+            I32 i0 = base;
+            I32 i1 = base + maxStride;
+            I32 i2 = base + sr + sg + sb - minStride;
+            I32 i3 = base + sr + sg + sb;
+            F32 w0 = 1.0f - fMax;
+            F32 w1 = fMax - fMid;
+            F32 w2 = fMid - fMin;
+            F32 w3 = fMin;
+            dst[3 * i] = w0 * nodes[i0] + w1 * nodes[i1] + w2 * nodes[i2] + w3 * nodes[i3];
+            dst[3 * i + 1] = w0 * nodes[i0 + 1] + w1 * nodes[i1 + 1] + w2 * nodes[i2 + 1] + w3 * nodes[i3 + 1];
+            dst[3 * i + 2] = w0 * nodes[i0 + 2] + w1 * nodes[i1 + 2] + w2 * nodes[i2 + 2] + w3 * nodes[i3 + 2];
         }
-        const SimpleCube &cube = findCube(color);
-        auto out = cube.map(color);
-        inCache = color;
-        outCache = out;
-        return out;
     }
 
 }
@@ -8,7 +8,8 @@ namespace image::memory {
     }
 
     Block MallocAllocator::alignedAlloc(Size size, Size alignment) noexcept {
-        auto ptr = std::aligned_alloc(alignment, size);
+        // aligned_alloc() needs a whole number of alignments.
+        auto ptr = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
         return Block { ptr, size };
     }
 
@@ -1,5 +1,6 @@
 #include <image/opencl/BufferDevice.hpp>
 
+#include <array>
 #include <iostream>
 
 using namespace image::opencl;
@@ -36,6 +37,30 @@ namespace image::memory {
         clEnqueueWriteBuffer(queue.get(), handle, true, 0, buf.size, buf.data(), 0, nullptr, nullptr);
     }
 
+    void OpenCLDevice::copyHostToDeviceRect(Buffer &buf, const BufferRect &rect) noexcept {
+        auto handle = reinterpret_cast<cl_mem>(buf.deviceHandle);
+        // Host and device buffers share a layout, so the same origin is used for both. Not blocking: the caller keeps
+        // the host block as it is until sync(), and can decode the next band meanwhile.
+        std::array<std::size_t, 3> origin { rect.x, rect.y, 0 };
+        std::array<std::size_t, 3> region { rect.width, rect.height, 1 };
+        auto ret = clEnqueueWriteBufferRect(queue.get(), handle, false, origin.data(), origin.data(), region.data(),
+                                            rect.rowPitch, 0, rect.rowPitch, 0, buf.data(), 0, nullptr, nullptr);
+        if (ret != CL_SUCCESS) {
+            std::cerr << "[OpenCLDevice] error copying region from host to device: " << Error(ret) << "\n";
+        }
+    }
+
+    void OpenCLDevice::copyDeviceToHostRect(Buffer &buf, const BufferRect &rect) noexcept {
+        auto handle = reinterpret_cast<cl_mem>(buf.deviceHandle);
+        std::array<std::size_t, 3> origin { rect.x, rect.y, 0 };
+        std::array<std::size_t, 3> region { rect.width, rect.height, 1 };
+        auto ret = clEnqueueReadBufferRect(queue.get(), handle, true, origin.data(), origin.data(), region.data(),
+                                           rect.rowPitch, 0, rect.rowPitch, 0, buf.data(), 0, nullptr, nullptr);
+        if (ret != CL_SUCCESS) {
+            std::cerr << "[OpenCLDevice] error copying region from device to host: " << Error(ret) << "\n";
+        }
+    }
+
     OpenCLDevice::OpenCLDevice(const ContextHandle &ctx, const CommandQueueHandle &queue) noexcept : ctx(ctx), queue(queue) {
         ctx.incRef();
         queue.incRef();
@@ -45,15 +70,11 @@ namespace image::memory {
 
     void OpenCLImageDevice::malloc(Buffer &buf) noexcept {
         cl_int ret;
-        // TODO: Generalise format and desc
-        cl_image_format format;
-        format.image_channel_order = CL_RGBA;
-        format.image_channel_data_type = CL_FLOAT;
         cl_image_desc desc;
-        desc.image_type = CL_MEM_OBJECT_IMAGE3D;
+        desc.image_type = imageSize.size() == 2 ? CL_MEM_OBJECT_IMAGE2D : CL_MEM_OBJECT_IMAGE3D;
         desc.image_width = imageSize.at(0);
         desc.image_height = imageSize.at(1);
-        desc.image_depth = imageSize.at(2);
+        desc.image_depth = imageSize.size() == 2 ? 1 : imageSize.at(2);
         desc.image_array_size = 0;
         desc.image_row_pitch = 0;
         desc.image_slice_pitch = 0;
@@ -61,6 +82,9 @@ namespace image::memory {
         desc.num_samples = 0;
         desc.buffer = nullptr;
         cl_mem handle = clCreateImage(ctx.get(), CL_MEM_READ_WRITE, &format, &desc, nullptr, &ret);
+        if (ret != CL_SUCCESS) {
+            std::cerr << "[OpenCLImageDevice] error creating image: " << Error(ret) << "\n";
+        }
         buf.deviceHandle = reinterpret_cast<intptr_t>(handle);
     }
 
@@ -79,7 +103,7 @@ namespace image::memory {
         // std::cerr << "[OpenCLImageDevice] copying: " << std::hex << buf.size << std::dec
         //           << " bytes to host ptr " << std::hex << buf.data() << std::dec << "\n";
         std::array<std::size_t, 3> origin { 0, 0, 0 };
-        std::array<std::size_t, 3> region { imageSize.at(0), imageSize.at(1), imageSize.at(2) };
+        auto region = this->region();
         auto ret = clEnqueueReadImage(queue.get(), handle, true, origin.data(), region.data(), 0, 0, buf.data(), 0, nullptr, nullptr);
         if (ret != CL_SUCCESS) {
             std::cerr << "[OpenCLImageDevice] error copying from device to host: " << Error(ret) << "\n";
@@ -96,7 +120,7 @@ namespace image::memory {
         // std::cerr << "[OpenCLImageDevice] copying: " << std::hex << buf.size << std::dec
         //           << " bytes from host ptr " << std::hex << buf.data() << std::dec << "\n";
         std::array<std::size_t, 3> origin { 0, 0, 0 };
-        std::array<std::size_t, 3> region { imageSize.at(0), imageSize.at(1), imageSize.at(2) };
+        auto region = this->region();
         auto ret = clEnqueueWriteImage(queue.get(), handle, true, origin.data(), region.data(), 0, 0, buf.data(), 0, nullptr, &ev);
         if (ret != CL_SUCCESS) {
             std::cerr << "[OpenCLImageDevice] error copying from host to device: " << Error(ret) << "\n";
@@ -107,11 +131,55 @@ namespace image::memory {
         }
     }
 
+    void OpenCLImageDevice::copyHostToDeviceRect(Buffer &buf, const BufferRect &rect) noexcept {
+        auto handle = reinterpret_cast<cl_mem>(buf.deviceHandle);
+        // Rects are in bytes horizontally, images are addressed in pixels.
+        auto px = pixelSize();
+        std::array<std::size_t, 3> origin { rect.x / px, rect.y, 0 };
+        std::array<std::size_t, 3> region { rect.width / px, rect.height, 1 };
+        auto hostPtr = static_cast<char *>(buf.data()) + rect.y * rect.rowPitch + rect.x;
+        // Not blocking, as for buffers.
+        auto ret = clEnqueueWriteImage(
+            queue.get(), handle, false, origin.data(), region.data(), rect.rowPitch, 0, hostPtr, 0, nullptr, nullptr);
+        if (ret != CL_SUCCESS) {
+            std::cerr << "[OpenCLImageDevice] error copying region from host to device: " << Error(ret) << "\n";
+        }
+    }
+
+    std::array<std::size_t, 3> OpenCLImageDevice::region() const noexcept {
+        return { imageSize.at(0), imageSize.at(1), imageSize.size() == 2 ? 1 : imageSize.at(2) };
+    }
+
+    Size OpenCLImageDevice::pixelSize() const noexcept {
+        Size channels = 1;
+        switch (format.image_channel_order) {
+        case CL_RG:
+            channels = 2;
+            break;
+        case CL_RGB:
+            channels = 3;
+            break;
+        case CL_RGBA:
+            channels = 4;
+            break;
+        }
+        switch (format.image_channel_data_type) {
+        case CL_HALF_FLOAT:
+        case CL_UNORM_INT16:
+            return channels * 2;
+        case CL_FLOAT:
+            return channels * 4;
+        default:
+            return channels;
+        }
+    }
+
     OpenCLImageDevice::OpenCLImageDevice(
         const ContextHandle &ctx,
         const CommandQueueHandle &queue,
-        const SmallVectorImpl<Size> &imageSize
-    ) noexcept : ctx(ctx), queue(queue), imageSize(imageSize) {
+        const SmallVectorImpl<Size> &imageSize,
+        const cl_image_format &format
+    ) noexcept : ctx(ctx), queue(queue), imageSize(imageSize), format(format) {
         ctx.incRef();
         queue.incRef();
     }
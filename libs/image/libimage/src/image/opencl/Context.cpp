@@ -93,7 +93,8 @@ namespace image::opencl {
                   << "\t    Max image size: " << device.maxImageWidth << "x"
                   << device.maxImageHeight << " pixels\n"
                   << "\t Max compute units: " << device.maxComputeUnits << "\n"
-                  << "\tMax work item dims: " << device.maxWorkItemDims << "\n";
+                  << "\tMax work item dims: " << device.maxWorkItemDims << "\n"
+                  << "\tMax work group size: " << device.maxWorkGroupSize << "\n";
     }
 
     Device getDevice(cl_device_id deviceId) {
@@ -136,6 +137,10 @@ namespace image::opencl {
         // Max work item dims
         ret = clGetDeviceInfo(deviceId, CL_DEVICE_MAX_WORK_ITEM_DIMENSIONS, sizeof(cl_uint), &device.maxWorkItemDims, nullptr);
 
+        // Max work group size
+        ret = clGetDeviceInfo(deviceId, CL_DEVICE_MAX_WORK_GROUP_SIZE, sizeof(size_t), &device.maxWorkGroupSize, nullptr);
+        if (ret != CL_SUCCESS) { throw Error(ret); }
+
         return device;
     }
 
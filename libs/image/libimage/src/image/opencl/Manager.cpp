@@ -34,8 +34,10 @@ namespace image::opencl {
         return theManager_;
     }
 
-    Expected<Program, Error> Manager::programFromResource(const String &filename) noexcept { 
-        if (auto it = programs.find(filename); it != programs.end()) {
+    Expected<Program, Error> Manager::programFromResource(const String &filename, const String &options) noexcept {
+        // Held while building too, so that two threads wanting the same program don't both build it.
+        std::lock_guard lock(programsMutex);
+        if (auto it = programs.find({ filename, options }); it != programs.end()) {
             return it->second;
         }
 
@@ -49,12 +51,12 @@ namespace image::opencl {
         }
         auto prog = std::move(*maybeProg);
 
-        auto buildResult = prog.build();
+        auto buildResult = prog.build(options);
         if (buildResult.hasError()) {
             return Unexpected(maybeProg.error());
         }
 
-        programs.insert({filename, prog});
+        programs.insert({ { filename, options }, prog });
         return prog;
     }
 
@@ -1,6 +1,7 @@
 #include <image/opencl/Program.hpp>
 
 #include <array>
+#include <cassert>
 #include <vector>
 
 namespace image::opencl {
@@ -11,6 +12,12 @@ namespace image::opencl {
         return out;
     }
 
+    size_t Kernel::getWorkGroupSize(cl_device_id device) const noexcept {
+        size_t out = 1;
+        clGetKernelWorkGroupInfo(handle.get(), device, CL_KERNEL_WORK_GROUP_SIZE, sizeof(size_t), &out, nullptr);
+        return out;
+    }
+
     Expected<void, Error> Kernel::setArg(cl_uint idx, const std::nullptr_t&) noexcept {
         cl_int ret = clSetKernelArg(handle.get(), idx, 0, nullptr);
         if (ret != CL_SUCCESS) {
@@ -56,11 +63,19 @@ namespace image::opencl {
     }
 
     Expected<void, Error> Kernel::run(const CommandQueueHandle &queue, const Shape &globalWorkShape) noexcept {
+        return run(queue, globalWorkShape, Shape {});
+    }
+
+    Expected<void, Error> Kernel::run(const CommandQueueHandle &queue,
+                                      const Shape &globalWorkShape,
+                                      const Shape &localWorkShape) noexcept {
+        // An empty local shape leaves the work-group size up to the implementation.
+        assert(localWorkShape.dims().empty() || localWorkShape.dims().size() == globalWorkShape.dims().size());
         cl_event ev;
         cl_int ret = clEnqueueNDRangeKernel(
             queue.get(), handle.get(),
             globalWorkShape.dims().size(), nullptr, globalWorkShape.begin(),
-            nullptr, 0, nullptr, &ev
+            localWorkShape.dims().empty() ? nullptr : localWorkShape.begin(), 0, nullptr, &ev
         );
         if (ret != CL_SUCCESS) {
             std::cerr << "[OpenCL] Error running kernel\n";
@@ -86,7 +101,7 @@ namespace image::opencl {
         return prog;
     }
 
-    Expected<void, Error> Program::build() noexcept {
+    Expected<void, Error> Program::build(const String &options) noexcept {
         cl_int ret;
 
         // Get context.
@@ -104,7 +119,7 @@ namespace image::opencl {
         if (ret != CL_SUCCESS) { return Unexpected(Error(ret)); }
 
         // Build.
-        ret = clBuildProgram(handle.get(), numDevices, devices.data(), nullptr, nullptr, nullptr);
+        ret = clBuildProgram(handle.get(), numDevices, devices.data(), options.c_str(), nullptr, nullptr);
         if (ret == CL_BUILD_PROGRAM_FAILURE) {
             cl_device_id deviceHandle = devices.at(0);
             std::size_t logSize;
@@ -42,6 +42,10 @@ namespace image::serialization {
             auto &meta = layer.maskGen->getMeta();
             maskTree.put("generator", meta.id);
             maskTree.put("enabled", layer.maskGen->isEnabled);
+            if (layer.maskGen->isRefined()) {
+                maskTree.put("refinement.radius", layer.maskGen->refinement.radius);
+                maskTree.put("refinement.epsilon", layer.maskGen->refinement.epsilon);
+            }
             pt::ptree maskOptionsTree;
             auto serializerResult = ctx.maskGeneratorSerializationRegistry->create(meta.id);
             if (serializerResult.hasValue()) { serializerResult.value()->write(ctx, maskOptionsTree, layer.maskGen.get()); }
@@ -116,7 +120,7 @@ namespace image::serialization {
                     serialization->read(ctx, *options, filterSpec.get());
                 }
 
-                filterSpec->isEnabled = tree.get<bool>("enabled", true);
+                filterSpec->isEnabled = filterTree.get<bool>("enabled", true);
 
                 filters.filterSpecs.emplace_back(std::move(filterSpec));
             } else {
@@ -172,6 +176,8 @@ namespace image::serialization {
                 }
 
                 maskGen->isEnabled = maskTree->get<bool>("enabled", true);
+                maskGen->refinement.radius = maskTree->get<F32>("refinement.radius", 0.0f);
+                maskGen->refinement.epsilon = maskTree->get<F32>("refinement.epsilon", MaskRefinement {}.epsilon);
 
                 layer.maskGen = maskGen;
             } else {
@@ -210,6 +216,32 @@ namespace image::serialization {
         return success;
     }
 
+    Composition copyComposition(const Composition &comp) noexcept {
+        auto filterSerializationRegistry = makeFilterSerializationRegistry();
+        auto maskGeneratorSerializationRegistry = makeMaskGeneratorSerializationRegistry();
+        auto filterRegistry = makeFilterRegistry();
+        auto maskGeneratorRegistry = makeMaskGeneratorRegistry();
+        auto basePath = std::filesystem::current_path();
+        WriteContext writeCtx { basePath, &filterSerializationRegistry, &maskGeneratorSerializationRegistry };
+        ReadContext readCtx { basePath,
+                              &filterSerializationRegistry,
+                              &maskGeneratorSerializationRegistry,
+                              &filterRegistry,
+                              &maskGeneratorRegistry };
+
+        Composition copy;
+        copy.inputImage = comp.inputImage;
+        for (auto &&layer : comp.layers) {
+            pt::ptree tree;
+            write(writeCtx, tree, *layer);
+            auto layerCopy = std::make_shared<Layer>();
+            // Everything written has a registered type, so reading it back can't fail.
+            read(readCtx, tree, *layerCopy);
+            copy.layers.push_back(layerCopy);
+        }
+        return copy;
+    }
+
     Expected<Composition, CompositionLoadError>
     loadFromFile(const Path &path,
                  const FilterRegistry *filterRegistry,
@@ -1,5 +1,9 @@
 #include "MaskGeneratorSerialization.hpp"
 
+#include <limits>
+#include <sstream>
+#include <vector>
+
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/property_tree/ptree.hpp>
 
@@ -12,6 +16,10 @@ namespace image::serialization {
         auto &meta = maskGen->getMeta();
         tree.put("generator", meta.id);
         tree.put("enabled", maskGen->isEnabled);
+        if (maskGen->isRefined()) {
+            tree.put("refinement.radius", maskGen->refinement.radius);
+            tree.put("refinement.epsilon", maskGen->refinement.epsilon);
+        }
         pt::ptree subtree;
         auto serializerResult = ctx.maskGeneratorSerializationRegistry->create(meta.id);
         if (serializerResult.hasValue()) { serializerResult.value()->write(ctx, subtree, maskGen); }
@@ -49,6 +57,8 @@ namespace image::serialization {
             }
 
             maskGen->isEnabled = tree.get<bool>("enabled", true);
+            maskGen->refinement.radius = tree.get<F32>("refinement.radius", 0.0f);
+            maskGen->refinement.epsilon = tree.get<F32>("refinement.epsilon", MaskRefinement {}.epsilon);
 
             return maskGen;
         }
@@ -121,4 +131,55 @@ namespace image::serialization {
         return success;
     }
 
+    // Brush
+
+    void BrushMaskGeneratorSerialization::write(const WriteContext &,
+                                                pt::ptree &tree,
+                                                const AbstractMaskGenerator *maskGen) const noexcept {
+        auto g = cast<BrushMaskGenerator>(maskGen);
+        pt::ptree strokesTree;
+        for (auto &&stroke : g->strokes) {
+            pt::ptree strokeTree;
+            strokeTree.put("radius", stroke.radius);
+            strokeTree.put("hardness", stroke.hardness);
+            strokeTree.put("erase", stroke.erase);
+            // Strokes can have thousands of points, so store them as a flat list of coordinates in one string rather
+            // than as a tree node per point.
+            std::ostringstream points;
+            // Enough digits that reading a point back gives exactly the same float.
+            points.precision(std::numeric_limits<F32>::max_digits10);
+            for (auto &&point : stroke.points) { points << point.x << ' ' << point.y << ' '; }
+            strokeTree.put("points", points.str());
+            strokesTree.push_back(std::make_pair("", strokeTree));
+        }
+        tree.put_child("strokes", strokesTree);
+    }
+
+    Expected<void, ReadError> BrushMaskGeneratorSerialization::read(const ReadContext &,
+                                                                    const pt::ptree &tree,
+                                                                    AbstractMaskGenerator *maskGen) const noexcept {
+        auto g = cast<BrushMaskGenerator>(maskGen);
+        g->clearStrokes();
+        if (auto strokesTree = tree.get_child_optional("strokes")) {
+            for (auto &&[key, strokeTree] : *strokesTree) {
+                BrushStroke stroke;
+                stroke.radius = strokeTree.get<F32>("radius", stroke.radius);
+                stroke.hardness = strokeTree.get<F32>("hardness", stroke.hardness);
+                stroke.erase = strokeTree.get<bool>("erase", stroke.erase);
+                std::istringstream points { strokeTree.get<String>("points", "") };
+                std::vector<F32> coords;
+                F32 coord;
+                while (points >> coord) { coords.push_back(coord); }
+                if (!points.eof() || coords.size() % 2 != 0) {
+                    return Unexpected(ReadError { "BrushMaskGenerator", "points", "Invalid point list" });
+                }
+                for (memory::Size i = 0; i < coords.size(); i += 2) {
+                    stroke.points.push_back(glm::vec2 { coords[i], coords[i + 1] });
+                }
+                g->strokes.push_back(std::move(stroke));
+            }
+        }
+        return success;
+    }
+
 }
@@ -34,6 +34,13 @@ namespace image::serialization {
         read(const ReadContext &ctx, const pt::ptree &tree, AbstractMaskGenerator *filter) const noexcept override;
     };
 
+    struct BrushMaskGeneratorSerialization final : public MaskGeneratorSerialization {
+        virtual void
+        write(const WriteContext &ctx, pt::ptree &tree, const AbstractMaskGenerator *filter) const noexcept override;
+        virtual Expected<void, ReadError>
+        read(const ReadContext &ctx, const pt::ptree &tree, AbstractMaskGenerator *filter) const noexcept override;
+    };
+
     // Registry
 
     namespace {
@@ -49,6 +56,7 @@ namespace image::serialization {
 
         registerMaskGeneratorSerialization<LumaMaskGenerator, LumaMaskGeneratorSerialization>(reg);
         registerMaskGeneratorSerialization<LinearGradientMaskSpec, LinearGradientMaskGeneratorSerialization>(reg);
+        registerMaskGeneratorSerialization<BrushMaskGenerator, BrushMaskGeneratorSerialization>(reg);
 
         return reg;
     }